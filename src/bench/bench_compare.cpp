@@ -0,0 +1,103 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <algorithm>
+
+using samples_t = std::map<std::string, std::vector<double>>; // "<day> <part>" -> microseconds
+
+samples_t load_results(const std::string& file){
+    samples_t ret;
+    std::ifstream fs(file);
+    std::string line;
+    while(std::getline(fs, line)) {
+        std::istringstream iss(line);
+        std::string day, part;
+        double us;
+        if(iss >> day >> part >> us){
+            ret[day + " " + part].push_back(us);
+        }
+    }
+    return ret;
+}
+
+double median(std::vector<double> v){
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n/2] : (v[n/2-1] + v[n/2]) / 2.0;
+}
+
+// one-sided mann-whitney u test, p-value for "current is slower than baseline".
+// normal approximation with tie and continuity correction, fine from about 8 samples a side
+double mann_whitney_slower(const std::vector<double>& baseline, const std::vector<double>& current)
+{
+    struct sample_t { double value; bool is_current; };
+    std::vector<sample_t> all;
+    for(double v : baseline) all.push_back({ v, false });
+    for(double v : current) all.push_back({ v, true });
+    std::sort(all.begin(), all.end(), [](const sample_t& a, const sample_t& b){ return a.value < b.value; });
+
+    double n1 = (double)baseline.size(), n2 = (double)current.size(), n = n1 + n2;
+    double rank_sum = 0, tie_term = 0;
+
+    for(size_t i=0; i<all.size(); ){
+        size_t j = i;
+        while(j < all.size() && all[j].value == all[i].value){
+            ++j;
+        }
+        double rank = (i + 1 + j) / 2.0; // average of ranks i+1..j
+        for(size_t k=i; k<j; ++k){
+            rank_sum += all[k].is_current ? rank : 0;
+        }
+        double t = (double)(j - i);
+        tie_term += t*t*t - t;
+        i = j;
+    }
+
+    double u = rank_sum - n2 * (n2 + 1) / 2.0;
+    double mean = n1 * n2 / 2.0;
+    double var = n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1)));
+    if(var <= 0){
+        return 1.0;
+    }
+
+    double z = (u - mean - 0.5) / std::sqrt(var);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 3){
+        std::cerr << "usage: bench_compare <baseline results> <current results> [alpha=0.01] [min slowdown=0.05]" << std::endl;
+        return 2;
+    }
+
+    auto baseline = load_results(argv[1]);
+    auto current = load_results(argv[2]);
+    double alpha = argc > 3 ? std::atof(argv[3]) : 0.01;
+    double min_slowdown = argc > 4 ? std::atof(argv[4]) : 0.05;
+
+    int regressions = 0;
+    for(auto& [key, cur] : current){
+        auto it = baseline.find(key);
+        if(it == baseline.end()){
+            std::cout << key << ": no baseline" << std::endl;
+            continue;
+        }
+
+        double base_median = median(it->second);
+        double cur_median = median(cur);
+        double change = base_median > 0 ? cur_median / base_median - 1.0 : 0.0;
+        double p = mann_whitney_slower(it->second, cur);
+        bool regressed = p < alpha && change > min_slowdown;
+        regressions += regressed;
+
+        std::cout << key << ": " << base_median << "us -> " << cur_median << "us (" << (change >= 0 ? "+" : "") << change * 100.0
+                  << "%), p=" << p << (regressed ? "  REGRESSION" : "") << std::endl;
+    }
+
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <unordered_set>
+#include <unordered_map>
+#include <timer.hpp>
+#include <flat_hash.hpp>
+
+// insert and lookup throughput and heap bytes per entry of the flat tables against the node based standard ones.
+// usage: hash_bench [entries=1000000] [repeats=5]
+
+// shared byte count so a container's footprint can be read off after building it
+inline size_t g_counted_bytes = 0;
+
+template<typename T>
+struct counting_allocator {
+    using value_type = T;
+
+    counting_allocator() = default;
+    template<typename U>
+    counting_allocator(const counting_allocator<U>&) {}
+
+    T* allocate(size_t n) {
+        g_counted_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        g_counted_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const counting_allocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const counting_allocator<U>&) const { return false; }
+};
+
+struct result_t {
+    double insert_ns = 0;
+    double hit_ns = 0;
+    double miss_ns = 0;
+    double bytes_per_entry = 0;
+};
+
+// Set is built empty, filled from keys, then probed with every key and with as many keys that are absent
+template<typename Set, typename Key>
+result_t measure(const std::vector<Key>& keys, const std::vector<Key>& missing, int repeats)
+{
+    result_t best { 1e30, 1e30, 1e30, 0 };
+    size_t found = 0;
+
+    for(int r=0; r<repeats; ++r)
+    {
+        Set set;
+        timer t;
+
+        t.start();
+        for(auto& key : keys){
+            set.insert(key);
+        }
+        t.stop();
+        best.insert_ns = std::min(best.insert_ns, t.microseconds() * 1000.0 / keys.size());
+
+        t.start();
+        for(auto& key : keys){
+            found += set.count(key);
+        }
+        t.stop();
+        best.hit_ns = std::min(best.hit_ns, t.microseconds() * 1000.0 / keys.size());
+
+        t.start();
+        for(auto& key : missing){
+            found += set.count(key);
+        }
+        t.stop();
+        best.miss_ns = std::min(best.miss_ns, t.microseconds() * 1000.0 / missing.size());
+    }
+
+    if(found != keys.size() * repeats){
+        std::cout << "lookup mismatch" << std::endl;
+    }
+    return best;
+}
+
+template<typename CountedSet, typename Key>
+double bytes_per_entry(const std::vector<Key>& keys)
+{
+    size_t before = g_counted_bytes;
+    CountedSet set;
+    for(auto& key : keys){
+        set.insert(key);
+    }
+    return (double)(g_counted_bytes - before) / keys.size();
+}
+
+void print(const std::string& name, const result_t& r)
+{
+    std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << r.insert_ns
+              << std::setw(10) << r.hit_ns
+              << std::setw(10) << r.miss_ns
+              << std::setw(12) << r.bytes_per_entry << std::endl;
+}
+
+template<typename Key, typename Make>
+void compare(const std::string& key_name, size_t entries, int repeats, Make make)
+{
+    std::mt19937_64 rng(46);
+    std::vector<Key> keys, missing;
+    std::unordered_set<Key> seen;
+    while(keys.size() < entries){
+        Key key = make(rng);
+        if(seen.insert(key).second){
+            keys.push_back(key);
+        }
+    }
+    while(missing.size() < entries){
+        Key key = make(rng);
+        if(!seen.count(key)){
+            missing.push_back(key);
+        }
+    }
+
+    auto std_result = measure<std::unordered_set<Key>>(keys, missing, repeats);
+    std_result.bytes_per_entry = bytes_per_entry<std::unordered_set<Key, std::hash<Key>, std::equal_to<Key>, counting_allocator<Key>>>(keys);
+    print("std::unordered_set<" + key_name + ">", std_result);
+
+    auto flat_result = measure<flat_hash_set<Key>>(keys, missing, repeats);
+    flat_result.bytes_per_entry = bytes_per_entry<flat_hash_set<Key, std::hash<Key>, std::equal_to<Key>, counting_allocator<Key>>>(keys);
+    print("flat_hash_set<" + key_name + ">", flat_result);
+}
+
+int main(int argc, char** argv)
+{
+    size_t entries = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    int repeats = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    std::cout << entries << " entries, best of " << repeats << std::endl;
+    std::cout << std::left << std::setw(36) << "container" << std::right
+              << std::setw(10) << "insert ns" << std::setw(10) << "hit ns" << std::setw(10) << "miss ns"
+              << std::setw(12) << "bytes/entry" << std::endl;
+
+    compare<uint64_t>("uint64_t", entries, repeats, [](std::mt19937_64& rng){ return rng(); });
+
+    // grid positions packed in a word, the shape of most memo and visited keys in this repo
+    compare<uint64_t>("packed x,y", entries, repeats, [](std::mt19937_64& rng){ return (rng() % 4096) << 32 | (rng() % 4096); });
+
+    compare<std::string>("string", entries, repeats, [](std::mt19937_64& rng){
+        std::string s(12, '.');
+        for(char& c : s){
+            c = "#."[rng() & 1];
+        }
+        return s + std::to_string(rng() % 1000);
+    });
+
+    return 0;
+}
@@ -1,8 +1,12 @@
 ﻿#include <vector>
 #include <iostream>
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <vector>
+#include <line_stream.hpp>
+#include <thread_pool.hpp>
+#include <bench.hpp>
 
 struct rotation_t{
     char direction;
@@ -25,48 +29,105 @@ int mod(int a, int b) {
     return ((a % b) + b) % b;
 }
 
-int part1(const rotations_t& rotations)
+int signed_distance(const rotation_t& rotation) {
+    return rotation.direction == 'L' ? -rotation.distance : rotation.distance;
+}
+
+struct dial_counts_t {
+    int64_t part1 = 0; // stops on zero
+    int64_t part2 = 0; // passes over zero
+};
+
+// pos is kept in [0, 100)
+void turn(int& pos, int dist, dial_counts_t& counts)
 {
-    int password = 0;
-    int pos = 50;
+    int abs_dist = std::abs(dist);
+    int target = (dist > 0) ? mod(-pos, 100) : pos;
+    int first = (target == 0) ? 100 : target;
 
-    for(auto& rotation : rotations){
-        pos += rotation.direction == 'L' ? -rotation.distance : rotation.distance;
-        password += mod(pos, 100) == 0;
+    if (first <= abs_dist){
+        counts.part2 += 1 + (abs_dist - first) / 100;
     }
 
-    return password;
+    pos = mod(pos + dist, 100);
+    counts.part1 += pos == 0;
 }
 
-int part2(const rotations_t& rotations)
+dial_counts_t count_zeros(const rotations_t& rotations, size_t begin, size_t end, int pos)
 {
-    int password = 0;
-    int pos = 50;
+    dial_counts_t counts;
+    for(size_t i=begin; i<end; ++i){
+        turn(pos, signed_distance(rotations[i]), counts);
+    }
+    return counts;
+}
 
-    for(auto& rotation : rotations){
-        int dist = rotation.direction == 'L' ? -rotation.distance :  rotation.distance;
-        int abs_dist = std::abs(dist);
-        int target = (dist > 0) ? mod(-pos, 100) : mod(pos, 100);
-        int first = (target == 0) ? 100 : target;
+// only the dial position going into a chunk depends on earlier chunks, and that is 50 plus the prefix sum of
+// their distances mod 100. so sum each chunk, scan the sums, then count every chunk from its own start
+dial_counts_t simulate(const rotations_t& rotations)
+{
+    const size_t chunk_size = 1 << 16;
+    int chunks = (int)((rotations.size() + chunk_size - 1) / chunk_size);
 
-        if (first <= abs_dist){
-            password += 1 + (abs_dist - first) / 100;
+    std::vector<int> starts(chunks + 1, 0);
+
+    parallel_for(0, chunks, [&](int c){
+        size_t end = std::min(rotations.size(), (c+1) * chunk_size);
+        int sum = 0;
+        for(size_t i=c*chunk_size; i<end; ++i){
+            sum = (sum + signed_distance(rotations[i])) % 100;
         }
+        starts[c+1] = sum;
+    });
 
-        pos += dist;
+    starts[0] = 50;
+    for(int c=0; c<chunks; ++c){
+        starts[c+1] = mod(starts[c] + starts[c+1], 100);
     }
 
-    return password;
+    auto add = [](const dial_counts_t& a, const dial_counts_t& b){
+        return dial_counts_t { a.part1 + b.part1, a.part2 + b.part2 };
+    };
+
+    return parallel_reduce(0, chunks, dial_counts_t(), [&](int c){
+        return count_zeros(rotations, c*chunk_size, std::min(rotations.size(), (c+1) * chunk_size), starts[c]);
+    }, add);
+}
+
+// bounded memory, the running dial position is all that is kept between lines
+dial_counts_t simulate_stream(const std::string& file)
+{
+    dial_counts_t counts;
+    int pos = 50;
+
+    line_stream stream(file);
+    stream.for_each_line([&](std::string_view line){
+        if(line.empty()){
+            return;
+        }
+        int distance = 0;
+        for(char c : line.substr(1)){
+            distance = distance * 10 + (c - '0');
+        }
+        turn(pos, signed_distance({ line[0], distance }), counts);
+    });
+
+    return counts;
+}
+
+dial_counts_t solve(const std::string& file)
+{
+    return prefer_streaming(file) ? simulate_stream(file) : simulate(load_input(file));
 }
 
 void main()
 {
-    auto test_values = load_input("../src/day01/test_input.txt");
-    auto actual_values = load_input("../src/day01/input.txt");
+    auto test_counts = solve("../src/day01/test_input.txt");
+    auto actual_counts = bench("day01", "both", [&]{ return solve("../src/day01/input.txt"); });
 
-    std::cout << "part1: " << part1(test_values) << std::endl;
-    std::cout << "part1: " << part1(actual_values) << std::endl;
+    std::cout << "part1: " << test_counts.part1 << std::endl;
+    std::cout << "part1: " << actual_counts.part1 << std::endl;
 
-    std::cout << "part2: " << part2(test_values) << std::endl;
-    std::cout << "part2: " << part2(actual_values) << std::endl;
+    std::cout << "part2: " << test_counts.part2 << std::endl;
+    std::cout << "part2: " << actual_counts.part2 << std::endl;
 }
\ No newline at end of file
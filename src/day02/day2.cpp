@@ -3,6 +3,9 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <functional>
+#include <bench.hpp>
+#include <thread_pool.hpp>
 
 struct id_t {
     size_t first;
@@ -26,10 +29,12 @@ ids_t load_input(const std::string& file){
     return ret;
 }
 
+// ranges are independent, each one is summed on whichever thread picks it up
 size_t part1(const ids_t& ids)
 {
-    size_t sum = 0;
-    for(auto& [first, second] : ids) {
+    return parallel_reduce(0, (int)ids.size(), size_t(0), [&](int r){
+        auto [first, second] = ids[r];
+        size_t sum = 0;
         for (size_t i=first; i<=second; ++i) {
             std::string str = std::to_string(i);
 
@@ -42,14 +47,15 @@ size_t part1(const ids_t& ids)
                 sum += i;
             }
         }
-    }
-    return sum;
+        return sum;
+    }, std::plus<size_t>());
 }
 
 size_t part2(const ids_t& ids)
 {
-    size_t sum = 0;
-    for (auto& [first, second] : ids) {
+    return parallel_reduce(0, (int)ids.size(), size_t(0), [&](int r){
+        auto [first, second] = ids[r];
+        size_t sum = 0;
         for (size_t i = first; i <= second; ++i) {
             std::string str = std::to_string(i);
             size_t len = str.size();
@@ -81,8 +87,8 @@ size_t part2(const ids_t& ids)
                 }
             }
         }
-    }
-    return sum;
+        return sum;
+    }, std::plus<size_t>());
 }
 
 void main()
@@ -91,8 +97,8 @@ void main()
     auto actual_values = load_input("../src/day02/input.txt");
 
     std::cout << "part1: " << part1(test_values) << std::endl;
-    std::cout << "part1: " << part1(actual_values) << std::endl;
+    std::cout << "part1: " << bench("day02", "part1", [&]{ return part1(actual_values); }) << std::endl;
 
     std::cout << "part2: " << part2(test_values) << std::endl;
-    std::cout << "part2: " << part2(actual_values) << std::endl;
+    std::cout << "part2: " << bench("day02", "part2", [&]{ return part2(actual_values); }) << std::endl;
 }
\ No newline at end of file
@@ -3,6 +3,11 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <array>
+#include <string_view>
+#include <line_stream.hpp>
+#include <thread_pool.hpp>
+#include <bench.hpp>
 
 using banks_t = std::vector<std::string>;
 
@@ -16,54 +21,93 @@ banks_t load_input(const std::string& file){
     return ret;
 }
 
-size_t find_largest_joltage(const std::string& bank, int target) {
-    int to_remove = (int)bank.size() - target;
+constexpr int max_target = 19; // digits that always fit in a size_t
 
-    std::vector<char> digits;
-    digits.reserve(bank.size());
+// greedy monotonic stack per target, all targets share the one walk over the bank. a stack never grows
+// past its target, a digit that finds it full and can't displace anything just uses up a removal
+template<int... Targets>
+std::array<size_t, sizeof...(Targets)> find_largest_joltages(std::string_view bank)
+{
+    static_assert(((Targets >= 1 && Targets <= max_target) && ...), "the stacks hold at most max_target digits");
+
+    constexpr int N = sizeof...(Targets);
+    constexpr int targets[N] = { Targets... };
+    char stacks[N][max_target];
+    int sizes[N] = {};
+    int to_remove[N];
+    for(int t=0; t<N; ++t){
+        to_remove[t] = (int)bank.size() - targets[t];
+    }
 
     for(char b : bank) {
-        while(to_remove > 0 && !digits.empty() && digits.back() < b) {
-            digits.pop_back();
-            --to_remove;
+        for(int t=0; t<N; ++t){
+            char* digits = stacks[t];
+            while(to_remove[t] > 0 && sizes[t] > 0 && digits[sizes[t]-1] < b) {
+                --sizes[t];
+                --to_remove[t];
+            }
+            if(sizes[t] < targets[t]){
+                digits[sizes[t]++] = b;
+            }else{
+                --to_remove[t];
+            }
         }
-        digits.push_back(b);
     }
 
-    while(to_remove > 0) {
-        digits.pop_back();
-        --to_remove;
+    std::array<size_t, N> ret = {};
+    for(int t=0; t<N; ++t){
+        for(int i=0; i<sizes[t]; ++i){
+            ret[t] = ret[t] * 10 + (stacks[t][i] - '0');
+        }
     }
+    return ret;
+}
+
+struct joltage_totals_t {
+    size_t part1 = 0;
+    size_t part2 = 0;
+};
 
-    return std::stoull(std::string(digits.begin(), digits.begin() + target));
+joltage_totals_t total_joltages(const banks_t& banks)
+{
+    auto add = [](const joltage_totals_t& a, const joltage_totals_t& b){
+        return joltage_totals_t { a.part1 + b.part1, a.part2 + b.part2 };
+    };
+
+    return parallel_reduce(0, (int)banks.size(), joltage_totals_t(), [&](int i){
+        auto joltages = find_largest_joltages<2, 12>(banks[i]);
+        return joltage_totals_t { joltages[0], joltages[1] };
+    }, add, 64);
 }
 
-size_t part1(const banks_t& banks)
+// bounded memory, banks are folded into the running sums as they stream in
+joltage_totals_t total_joltages_stream(const std::string& file)
 {
-    size_t sum = 0;
-    for(auto& bank : banks){
-        sum += find_largest_joltage(bank, 2);
-    }
-    return sum;
+    joltage_totals_t totals;
+
+    line_stream stream(file);
+    stream.for_each_line([&](std::string_view bank){
+        auto joltages = find_largest_joltages<2, 12>(bank);
+        totals.part1 += joltages[0];
+        totals.part2 += joltages[1];
+    });
+
+    return totals;
 }
 
-size_t part2(const banks_t& banks)
+joltage_totals_t solve(const std::string& file)
 {
-    size_t sum = 0;
-    for(auto& bank : banks){
-        sum += find_largest_joltage(bank, 12);
-    }
-    return sum;
+    return prefer_streaming(file) ? total_joltages_stream(file) : total_joltages(load_input(file));
 }
 
 void main()
 {
-    auto test_values = load_input("../src/day03/test_input.txt");
-    auto actual_values = load_input("../src/day03/input.txt");
+    auto test_totals = solve("../src/day03/test_input.txt");
+    auto actual_totals = bench("day03", "both", [&]{ return solve("../src/day03/input.txt"); });
 
-    std::cout << "part1: " << part1(test_values) << std::endl;
-    std::cout << "part1: " << part1(actual_values) << std::endl;
+    std::cout << "part1: " << test_totals.part1 << std::endl;
+    std::cout << "part1: " << actual_totals.part1 << std::endl;
 
-    std::cout << "part2: " << part2(test_values) << std::endl;
-    std::cout << "part2: " << part2(actual_values) << std::endl;
+    std::cout << "part2: " << test_totals.part2 << std::endl;
+    std::cout << "part2: " << actual_totals.part2 << std::endl;
 }
\ No newline at end of file
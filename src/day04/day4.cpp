@@ -2,6 +2,11 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <bitset>
+#include <algorithm>
+#include <functional>
+#include <bench.hpp>
+#include <thread_pool.hpp>
 
 struct grid_t {
     std::vector<char> data;
@@ -9,6 +14,7 @@ struct grid_t {
     int height = 0;
 
     char& operator()(int x, int y){ return data[y*width + x]; }
+    char operator()(int x, int y) const { return data[y*width + x]; }
 };
 
 grid_t load_input(const std::string& file){
@@ -23,59 +29,226 @@ grid_t load_input(const std::string& file){
     return ret;
 }
 
-bool removable(grid_t& grid, int px, int py) {
-    if(grid(px, py) != '@'){
-        return false;
-    }
+int popcount(uint64_t v) {
+    return (int)std::bitset<64>(v).count();
+}
 
-    int adjecent_papers = 0;
-    for(int y=std::max(py-1, 0); y<std::min(py+2, grid.height); ++y){
-        for(int x=std::max(px-1, 0); x<std::min(px+2, grid.width); ++x){
-            if(!(py == y && px == x)){
-                adjecent_papers += grid(x, y) == '@';
-                if(adjecent_papers == 4){
-                    return false;
-                }
-            }
+struct bitplane_t {
+    std::vector<uint64_t> words; // bit x of a row is column x, with a zero row of padding above and below
+    int stride = 0;
+    int height = 0;
+
+    const uint64_t* row(int y) const { return &words[(size_t)(y+1) * stride]; }
+    uint64_t* row(int y) { return &words[(size_t)(y+1) * stride]; }
+};
+
+bitplane_t to_bitplane(const grid_t& grid)
+{
+    bitplane_t plane;
+    plane.stride = (grid.width + 63) / 64;
+    plane.height = grid.height;
+    plane.words.assign((size_t)(grid.height + 2) * plane.stride, 0);
+
+    for(int y=0; y<grid.height; ++y){
+        uint64_t* row = plane.row(y);
+        for(int x=0; x<grid.width; ++x){
+            row[x >> 6] |= (uint64_t)(grid(x, y) == '@') << (x & 63);
         }
     }
+    return plane;
+}
+
+// column x-1 and x+1 lined up with column x
+uint64_t from_left(const uint64_t* row, int w) { return (row[w] << 1) | (w > 0 ? row[w-1] >> 63 : 0); }
+uint64_t from_right(const uint64_t* row, int w, int stride) { return (row[w] >> 1) | (w+1 < stride ? row[w+1] << 63 : 0); }
+
+// bit-sliced neighbour count for 64 cells at once, removable where fewer than 4 of the 8 are set
+uint64_t removable(const bitplane_t& plane, int y, int w)
+{
+    const uint64_t* up = plane.row(y-1);
+    const uint64_t* mid = plane.row(y);
+    const uint64_t* down = plane.row(y+1);
+
+    uint64_t neighbours[8] = {
+        from_left(up, w), up[w], from_right(up, w, plane.stride),
+        from_left(mid, w), from_right(mid, w, plane.stride),
+        from_left(down, w), down[w], from_right(down, w, plane.stride)
+    };
+
+    uint64_t ones = 0, twos = 0, four_or_more = 0;
+    for(uint64_t n : neighbours){
+        uint64_t carry = ones & n;
+        ones ^= n;
+        four_or_more |= twos & carry;
+        twos ^= carry;
+    }
 
-    return true;
+    return mid[w] & ~four_or_more;
 }
 
 int part1(grid_t& grid)
 {
+    bitplane_t plane = to_bitplane(grid);
+
     int sum = 0;
+    for(int y=0; y<plane.height; ++y){
+        for(int w=0; w<plane.stride; ++w){
+            sum += popcount(removable(plane, y, w));
+        }
+    }
+    return sum;
+}
+
+// k-core style peeling, neighbour counts are built once and only the cells around a removal are revisited.
+// every wave holds exactly the cells a full-grid rescan would remove in that round
+std::vector<int> peel(grid_t& grid)
+{
+    std::vector<int> neighbours(grid.data.size(), 0);
+    std::vector<int> wave, next_wave;
+
     for(int y=0; y<grid.height; ++y){
         for(int x=0; x<grid.width; ++x){
-            sum += removable(grid, x, y);
+            if(grid(x, y) != '@'){
+                continue;
+            }
+            for(int ny=std::max(y-1, 0); ny<std::min(y+2, grid.height); ++ny){
+                for(int nx=std::max(x-1, 0); nx<std::min(x+2, grid.width); ++nx){
+                    neighbours[y*grid.width + x] += !(ny == y && nx == x) && grid(nx, ny) == '@';
+                }
+            }
+            if(neighbours[y*grid.width + x] < 4){
+                wave.push_back(y*grid.width + x);
+            }
         }
     }
-    return sum;
+
+    std::vector<int> removed_per_round;
+    while(!wave.empty())
+    {
+        for(int idx : wave){
+            grid.data[idx] = '.';
+        }
+
+        for(int idx : wave){
+            int x = idx % grid.width, y = idx / grid.width;
+            for(int ny=std::max(y-1, 0); ny<std::min(y+2, grid.height); ++ny){
+                for(int nx=std::max(x-1, 0); nx<std::min(x+2, grid.width); ++nx){
+                    int n = ny*grid.width + nx;
+                    if(grid.data[n] == '@' && --neighbours[n] == 3){
+                        next_wave.push_back(n);
+                    }
+                }
+            }
+        }
+
+        removed_per_round.push_back((int)wave.size());
+        std::swap(wave, next_wave);
+        next_wave.clear();
+    }
+
+    return removed_per_round;
 }
 
 size_t part2(grid_t& grid)
 {
-    int sum = 0;
-    grid_t grid2 = grid;
-    bool all_removed = false;
-
-    while(!all_removed){
-        int removed = 0;
-        for(int y=0; y<grid.height; ++y){
-            for(int x=0; x<grid.width; ++x){
-                if(removable(grid, x, y)){
-                    removed++;
-                    grid2(x, y) = '.';
-                };
+    size_t sum = 0;
+    for(int removed : peel(grid)){
+        sum += removed;
+    }
+    return sum;
+}
+
+// removes every removable cell of a plane in synchronous rounds, the padding rows are left untouched
+bool peel_rounds(bitplane_t& plane, std::vector<uint64_t>& removed)
+{
+    bool changed = false;
+    removed.resize((size_t)plane.height * plane.stride);
+
+    while(true)
+    {
+        uint64_t any = 0;
+        for(int y=0; y<plane.height; ++y){
+            for(int w=0; w<plane.stride; ++w){
+                removed[(size_t)y*plane.stride + w] = removable(plane, y, w);
+                any |= removed[(size_t)y*plane.stride + w];
+            }
+        }
+
+        if(!any){
+            return changed;
+        }
+
+        changed = true;
+        for(int y=0; y<plane.height; ++y){
+            for(int w=0; w<plane.stride; ++w){
+                plane.row(y)[w] &= ~removed[(size_t)y*plane.stride + w];
             }
         }
-        sum += removed;
-        all_removed |= removed == 0;
-        grid = grid2;
     }
+}
 
-    return sum;
+// the grid is cut into bands of rows sized to stay in L2, each band peels locally against a snapshot of
+// the rows just outside it and bands are re-run until none of them changes. a stale halo only ever holds
+// cells that are still to be removed, so it can delay a removal but never cause a wrong one
+size_t part2_tiled(const grid_t& grid, int band_rows = 0)
+{
+    bitplane_t plane = to_bitplane(grid);
+    int stride = plane.stride;
+    if(band_rows <= 0){
+        band_rows = std::max(1, (256 * 1024 / 8) / std::max(stride, 1));
+    }
+
+    int bands = (plane.height + band_rows - 1) / band_rows;
+    std::vector<uint64_t> halos((size_t)bands * 2 * stride);
+
+    size_t before = 0;
+    for(uint64_t w : plane.words){
+        before += popcount(w);
+    }
+
+    // per thread scratch, indexed by the pool slot of whichever thread runs the band
+    auto& pool = thread_pool::global();
+    std::vector<bitplane_t> bands_scratch(pool.size());
+    std::vector<std::vector<uint64_t>> removed_scratch(pool.size());
+
+    bool changed = true;
+    while(changed)
+    {
+
+        parallel_for(0, bands, [&](int b){
+            int y0 = b * band_rows;
+            int y1 = std::min(y0 + band_rows, plane.height);
+            std::copy(plane.row(y0-1), plane.row(y0-1) + stride, &halos[(size_t)b*2*stride]);
+            std::copy(plane.row(y1), plane.row(y1) + stride, &halos[(size_t)(b*2+1)*stride]);
+        });
+
+        changed = pool.parallel_reduce(0, bands, false, [&](int b){
+            auto& band = bands_scratch[pool.slot()];
+            auto& removed = removed_scratch[pool.slot()];
+
+            int y0 = b * band_rows;
+            int y1 = std::min(y0 + band_rows, plane.height);
+
+            band.stride = stride;
+            band.height = y1 - y0;
+            band.words.resize((size_t)(band.height + 2) * stride);
+            std::copy(&halos[(size_t)b*2*stride], &halos[(size_t)(b*2+1)*stride], band.row(-1));
+            std::copy(plane.row(y0), plane.row(y1), band.row(0));
+            std::copy(&halos[(size_t)(b*2+1)*stride], &halos[(size_t)(b*2+2)*stride], band.row(band.height));
+
+            if(!peel_rounds(band, removed)){
+                return false;
+            }
+            std::copy(band.row(0), band.row(band.height), plane.row(y0));
+            return true;
+        }, std::logical_or<bool>());
+    }
+
+    size_t after = 0;
+    for(uint64_t w : plane.words){
+        after += popcount(w);
+    }
+    return before - after;
 }
 
 void main()
@@ -84,8 +257,11 @@ void main()
     auto actual_values = load_input("../src/day04/input.txt");
 
     std::cout << "part1: " << part1(test_values) << std::endl;
-    std::cout << "part1: " << part1(actual_values) << std::endl;
+    std::cout << "part1: " << bench("day04", "part1", [&]{ return part1(actual_values); }) << std::endl;
+
+    std::cout << "part2 tiled: " << part2_tiled(test_values, 3) << std::endl;
+    std::cout << "part2 tiled: " << bench("day04", "part2_tiled", [&]{ return part2_tiled(actual_values); }) << std::endl;
 
     std::cout << "part2: " << part2(test_values) << std::endl;
-    std::cout << "part2: " << part2(actual_values) << std::endl;
+    std::cout << "part2: " << bench("day04", "part2", [&]{ grid_t grid = actual_values; return part2(grid); }) << std::endl;
 }
\ No newline at end of file
@@ -3,6 +3,12 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <string_view>
+#include <cstdint>
+#include <cstdlib>
+#include <line_stream.hpp>
+#include <bench.hpp>
 
 struct range_t {
     size_t low;
@@ -14,13 +20,16 @@ struct database_t {
     std::vector<size_t> ids;
 };
 
-database_t load_input(const std::string& file){
+database_t load_input(const std::string& file, bool load_ids = true){
     database_t ret;
     std::ifstream fs(file);
     bool load_stage = 0;
     std::string line;
     while (std::getline(fs, line)) {
         if(line == ""){
+            if(!load_ids){
+                break;
+            }
             load_stage = 1;
             continue;
         }else if(load_stage == 0){
@@ -56,23 +65,221 @@ struct interval_set_t
         }   
     }
 
+    bool contains(size_t id) const {
+        auto after = ranges.upper_bound(id);
+        return after != ranges.begin() && id < std::prev(after)->second;
+    }
+
     std::map<size_t, size_t> ranges;
 };
 
-size_t part1(const database_t& database)
+// ranges that come and go. a sparse segment tree over ids [0, 2^bits), doubled as larger ids show up. a range
+// adds one to the count of the O(bits) nodes that tile it and counts are never pushed down, a node covers all
+// of its span while its own count is positive and otherwise what its children cover. overlaps are counted
+// instead of merged so an erase only takes its counts back off, and every query is a walk or two from the root
+class coverage_index_t
 {
-    size_t sum = 0;
-    for(auto& id : database.ids){
-        for(auto& range : database.id_ranges){
-            if(id >= range.low && id <= range.high){
-                sum++;
+public:
+    // the root spans at most 2^63 ids, so every covered length fits in a size_t
+    static constexpr size_t max_id = (size_t(1) << 63) - 1;
+
+    // false for an empty range (low > high) or one reaching past max_id, which are not stored
+    bool insert(const range_t& range) {
+        if(!valid(range)){
+            return false;
+        }
+        refs_[{ range.low, range.high }]++;
+        while(range.high >> bits_){
+            grow();
+        }
+        update(root_, 0, bits_, range.low, range.high, 1);
+        return true;
+    }
+
+    // takes back one earlier insert of the same range, false when there is none
+    bool erase(const range_t& range) {
+        if(!valid(range)){
+            return false;
+        }
+        auto it = refs_.find({ range.low, range.high });
+        if(it == refs_.end()){
+            return false;
+        }
+        if(--it->second == 0){
+            refs_.erase(it);
+        }
+        update(root_, 0, bits_, range.low, range.high, -1);
+        return true;
+    }
+
+    size_t total_covered() const { return nodes_[root_].covered; }
+
+    bool contains(size_t id) const {
+        if(id > max_id || id >> bits_){
+            return false;
+        }
+        for(int x=root_, bits=bits_; x>=0; x=nodes_[x].ch[(id >> bits) & 1]){
+            if(nodes_[x].count > 0){
+                return true;
+            }
+            if(bits-- == 0){
                 break;
             }
         }
+        return false;
+    }
+
+    // ids covered within [low, high], 0 when low > high
+    size_t covered(size_t low, size_t high) const { return low > high ? 0 : query(root_, 0, bits_, low, high); }
+
+private:
+    struct node_t {
+        int ch[2] = { -1, -1 };
+        int count = 0;      // ranges tiling through this node
+        size_t covered = 0; // ids covered in this node's span
+    };
+
+    static bool valid(const range_t& range) { return range.low <= range.high && range.high <= max_id; }
+
+    static size_t last_of(size_t lo, int bits) { return lo + ((size_t(1) << bits) - 1); }
+
+    // the old root becomes the low half of one twice as wide
+    void grow() {
+        if(nodes_[root_].count || nodes_[root_].ch[0] >= 0 || nodes_[root_].ch[1] >= 0){
+            int root = make_node();
+            nodes_[root].ch[0] = root_;
+            nodes_[root].covered = nodes_[root_].covered;
+            root_ = root;
+        }
+        bits_++;
+    }
+
+    int make_node() {
+        if(!free_.empty()){
+            int x = free_.back();
+            free_.pop_back();
+            nodes_[x] = node_t();
+            return x;
+        }
+        nodes_.emplace_back();
+        return (int)nodes_.size() - 1;
+    }
+
+    void pull(int x, int bits) {
+        auto& node = nodes_[x];
+        if(node.count > 0){
+            node.covered = last_of(0, bits) + 1;
+            return;
+        }
+        node.covered = 0;
+        for(int c : node.ch){
+            if(c >= 0){
+                node.covered += nodes_[c].covered;
+            }
+        }
+    }
+
+    // [low, high] overlaps x's span [lo, lo + 2^bits)
+    void update(int x, size_t lo, int bits, size_t low, size_t high, int delta)
+    {
+        if(low <= lo && last_of(lo, bits) <= high){
+            nodes_[x].count += delta;
+            pull(x, bits);
+            return;
+        }
+
+        size_t mid = lo + (size_t(1) << (bits-1));
+        for(int side=0; side<2; ++side)
+        {
+            size_t child_lo = side ? mid : lo;
+            if(high < child_lo || last_of(child_lo, bits-1) < low){
+                continue;
+            }
+
+            int child = nodes_[x].ch[side];
+            if(child < 0){
+                child = make_node();
+                nodes_[x].ch[side] = child;
+            }
+            update(child, child_lo, bits-1, low, high, delta);
+
+            auto& c = nodes_[child];
+            if(c.count == 0 && c.ch[0] < 0 && c.ch[1] < 0){
+                free_.push_back(child);
+                nodes_[x].ch[side] = -1;
+            }
+        }
+        pull(x, bits);
+    }
+
+    size_t query(int x, size_t lo, int bits, size_t low, size_t high) const
+    {
+        size_t last = last_of(lo, bits);
+        if(x < 0 || high < lo || last < low){
+            return 0;
+        }
+        if(low <= lo && last <= high){
+            return nodes_[x].covered;
+        }
+        if(nodes_[x].count > 0){
+            return std::min(high, last) - std::max(low, lo) + 1;
+        }
+
+        size_t mid = lo + (size_t(1) << (bits-1));
+        return query(nodes_[x].ch[0], lo, bits-1, low, high) + query(nodes_[x].ch[1], mid, bits-1, low, high);
+    }
+
+    std::vector<node_t> nodes_ = std::vector<node_t>(1);
+    std::vector<int> free_;
+    int root_ = 0;
+    int bits_ = 1;
+    std::map<std::pair<size_t, size_t>, int> refs_; // inserts per distinct range
+};
+
+size_t part1(const database_t& database)
+{
+    interval_set_t intervals;
+    for(auto& range : database.id_ranges){
+        intervals.insert(range);
+    }
+
+    size_t sum = 0;
+    for(auto& id : database.ids){
+        sum += intervals.contains(id);
     }
     return sum;
 }
 
+size_t parse_id(std::string_view s) {
+    size_t v = 0;
+    for(char c : s){
+        v = v * 10 + (c - '0');
+    }
+    return v;
+}
+
+// bounded memory, the ranges are merged into the index as they arrive and the ids are only ever checked against it
+size_t part1_stream(const std::string& file)
+{
+    interval_set_t intervals;
+    bool load_stage = 0;
+    size_t sum = 0;
+
+    line_stream stream(file);
+    stream.for_each_line([&](std::string_view line){
+        if(line.empty()){
+            load_stage = 1;
+        }else if(load_stage == 0){
+            auto dash_pos = line.find_first_of('-');
+            intervals.insert({ parse_id(line.substr(0, dash_pos)), parse_id(line.substr(dash_pos+1)) });
+        }else{
+            sum += intervals.contains(parse_id(line));
+        }
+    });
+
+    return sum;
+}
+
 size_t part2(const database_t& database)
 {
     interval_set_t intervals;
@@ -87,14 +294,81 @@ size_t part2(const database_t& database)
     return sum;
 }
 
+size_t part1_index(const database_t& database)
+{
+    coverage_index_t index;
+    for(auto& range : database.id_ranges){
+        index.insert(range);
+    }
+
+    size_t sum = 0;
+    for(auto& id : database.ids){
+        sum += index.contains(id);
+    }
+    return sum;
+}
+
+size_t part2_index(const database_t& database)
+{
+    coverage_index_t index;
+    for(auto& range : database.id_ranges){
+        index.insert(range);
+    }
+    return index.total_covered();
+}
+
+// every range is taken out and put back in turn and the coverage has to come back each time, then erasing them
+// all has to leave nothing. empty ranges and ranges never inserted are turned away
+bool check_index(const database_t& database)
+{
+    coverage_index_t index;
+    for(auto& range : database.id_ranges){
+        index.insert(range);
+    }
+
+    size_t total = index.total_covered();
+    if(total != part2(database) || index.covered(0, coverage_index_t::max_id) != total){
+        return false;
+    }
+    for(auto& range : database.id_ranges){
+        if(!index.erase(range) || !index.insert(range) || index.total_covered() != total){
+            return false;
+        }
+    }
+
+    if(index.insert({ 5, 4 }) || index.erase({ 5, 4 }) || index.erase({ 1, coverage_index_t::max_id }) || index.covered(5, 4) != 0){
+        return false;
+    }
+
+    for(auto& range : database.id_ranges){
+        index.erase(range);
+    }
+    return index.total_covered() == 0 && index.covered(0, coverage_index_t::max_id) == 0;
+}
+
 void main()
 {
+    std::string actual_file = "../src/day05/input.txt";
+    bool stream_ids = prefer_streaming(actual_file);
+
     auto test_values = load_input("../src/day05/test_input.txt");
-    auto actual_values = load_input("../src/day05/input.txt");
+    auto actual_values = load_input(actual_file, !stream_ids);
 
     std::cout << "part1: " << part1(test_values) << std::endl;
-    std::cout << "part1: " << part1(actual_values) << std::endl;
+    std::cout << "part1: " << bench("day05", "part1", [&]{ return stream_ids ? part1_stream(actual_file) : part1(actual_values); }) << std::endl;
 
     std::cout << "part2: " << part2(test_values) << std::endl;
-    std::cout << "part2: " << part2(actual_values) << std::endl;
+    std::cout << "part2: " << bench("day05", "part2", [&]{ return part2(actual_values); }) << std::endl;
+
+    std::cout << "part1 index: " << part1_index(test_values) << std::endl;
+    if(!stream_ids){
+        std::cout << "part1 index: " << bench("day05", "part1_index", [&]{ return part1_index(actual_values); }) << std::endl;
+    }
+
+    std::cout << "part2 index: " << part2_index(test_values) << std::endl;
+    std::cout << "part2 index: " << bench("day05", "part2_index", [&]{ return part2_index(actual_values); }) << std::endl;
+
+    if(std::getenv("AOC_SELF_CHECK")){
+        std::cout << "index check: " << (check_index(test_values) && check_index(actual_values) ? "ok" : "FAILED") << std::endl;
+    }
 }
\ No newline at end of file
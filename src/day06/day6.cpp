@@ -2,84 +2,195 @@
 #include <fstream>
 #include <string>
 #include <vector>
-#include <sstream>
+#include <cstdint>
+#include <bench.hpp>
 
-struct problem_t {
-    std::vector<char> digits;
-    int width = 0;
-    int height = 0;
-    char& operator()(int x, int y){ return digits[y*width + x]; }
+// stays on plain 64-bit arithmetic until an add or multiply overflows, then carries on in 128 bits. past that
+// the value is marked as overflowed, which sticks through later arithmetic and is what gets printed
+struct u128_t {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+    bool overflow = false;
+
+    u128_t() = default;
+    u128_t(uint64_t v) : lo(v) {}
+
+    bool is_zero() const { return !overflow && hi == 0 && lo == 0; }
 };
 
-problem_t load_input(const std::string& file){
-    problem_t ret;
-    std::ifstream fs(file);
-    std::string line;
-    while (std::getline(fs, line)) {
-        std::copy(line.begin(), line.end(), std::back_inserter(ret.digits));
-        ret.width = std::max(ret.width, (int)line.size());
-        ret.height++;
+u128_t& operator+=(u128_t& a, const u128_t& b) {
+    uint64_t lo = a.lo + b.lo;
+    uint64_t hi = a.hi + b.hi;
+    bool carry_out = hi < a.hi;
+    hi += lo < a.lo;
+    carry_out |= hi == 0 && lo < a.lo;
+    a.overflow |= b.overflow || carry_out;
+    a.hi = hi;
+    a.lo = lo;
+    return a;
+}
+
+// full 64x64 -> 128 product from 32-bit halves
+uint64_t mul_wide(uint64_t a, uint64_t b, uint64_t& hi) {
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+
+    uint64_t ll = a_lo * b_lo;
+    uint64_t lh = a_lo * b_hi;
+    uint64_t hl = a_hi * b_lo;
+    uint64_t hh = a_hi * b_hi;
+
+    uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+    hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return (mid << 32) | (uint32_t)ll;
+}
+
+u128_t& operator*=(u128_t& a, uint64_t b) {
+    if(a.hi == 0 && (b == 0 || a.lo <= UINT64_MAX / b)){
+        a.lo *= b;
+        return a;
     }
-    return ret;
+
+    uint64_t carry, top;
+    a.lo = mul_wide(a.lo, b, carry);
+    uint64_t hi = mul_wide(a.hi, b, top);
+    a.hi = hi + carry;
+    a.overflow |= top != 0 || a.hi < hi;
+    return a;
 }
 
-size_t part1(problem_t& problem)
-{
-    std::vector<std::vector<int>> matrix(problem.height-1);
-    std::vector<char> ops;
+// a product of two values that both need more than 64 bits needs more than 128
+u128_t& operator*=(u128_t& a, const u128_t& b) {
+    if(a.is_zero() || b.is_zero()){
+        return a = 0;
+    }
 
-    for(int y=0; y<problem.height; ++y){
-        std::string num;
-        for(int x=0; x<problem.width; ++x){
-            num += problem(x, y);
+    bool overflow = a.overflow || b.overflow || (a.hi && b.hi);
+    if(b.hi == 0){
+        a *= b.lo;
+    }else{
+        uint64_t lo = a.lo;
+        a = b;
+        a *= lo;
+    }
+    a.overflow |= overflow;
+    return a;
+}
+
+std::ostream& operator<<(std::ostream& os, u128_t v) {
+    if(v.overflow){
+        return os << "overflow (2^128 or more)";
+    }
+    if(v.hi == 0){
+        return os << v.lo;
+    }
+
+    std::string digits;
+    while(v.hi || v.lo){
+        uint32_t limbs[4] = { (uint32_t)(v.hi >> 32), (uint32_t)v.hi, (uint32_t)(v.lo >> 32), (uint32_t)v.lo };
+        uint64_t rem = 0;
+        for(auto& limb : limbs){
+            uint64_t cur = (rem << 32) | limb;
+            limb = (uint32_t)(cur / 10);
+            rem = cur % 10;
         }
+        v.hi = ((uint64_t)limbs[0] << 32) | limbs[1];
+        v.lo = ((uint64_t)limbs[2] << 32) | limbs[3];
+        digits.push_back((char)('0' + rem));
+    }
+    return os << std::string(digits.rbegin(), digits.rend());
+}
+
+// everything both parts need, gathered in one pass over the bytes with O(width) state
+struct worksheet_t {
+    std::vector<u128_t> row_sums;        // per problem, of the numbers read along each row
+    std::vector<u128_t> row_products;
+    std::vector<u128_t> column_numbers;   // per column, digits read top to bottom
+    std::vector<char> has_digit;          // per column
+    std::string ops;                      // the operator row
+};
+
+void scan_row(const std::string& line, worksheet_t& sheet)
+{
+    if(sheet.column_numbers.size() < line.size()){
+        sheet.column_numbers.resize(line.size(), 0);
+        sheet.has_digit.resize(line.size(), 0);
+    }
 
-        if(num.front() == '+' || num.front() == '*'){
-            char op;
-            std::istringstream iss(num);
-            while(iss >> op){
-                ops.push_back(op);
+    int problem = 0;
+    u128_t num = 0;
+    bool in_num = false;
+
+    for(int x=0; x<=line.size(); ++x){
+        char c = x < line.size() ? line[x] : ' ';
+        if(c >= '0' && c <= '9'){
+            uint64_t d = c - '0';
+            num *= 10;
+            num += d;
+            in_num = true;
+            sheet.column_numbers[x] *= 10;
+            sheet.column_numbers[x] += d;
+            sheet.has_digit[x] = 1;
+        }else if(in_num){
+            if(sheet.row_sums.size() <= problem){
+                sheet.row_sums.push_back(0);
+                sheet.row_products.push_back(1);
             }
+            sheet.row_sums[problem] += num;
+            sheet.row_products[problem] *= num;
+            problem++;
+            num = 0;
+            in_num = false;
+        }
+    }
+}
+
+worksheet_t load_input(const std::string& file){
+    worksheet_t ret;
+    std::ifstream fs(file);
+    std::string line;
+    while (std::getline(fs, line)) {
+        if(line.find_first_of("+*") != std::string::npos){
+            ret.ops = line;
         }else{
-            int inum;
-            std::istringstream iss(num);
-            while(iss >> inum){
-                matrix[y].push_back(inum);
-            }
+            scan_row(line, ret);
         }
     }
+    return ret;
+}
 
-    size_t sum = 0;
-    for(int x=0; x<matrix[0].size(); ++x){
-        size_t col_sum = matrix[0][x];
-        for(int y=1; y<matrix.size(); ++y){
-            col_sum = (ops[x] == '+') ? col_sum + matrix[y][x] : col_sum * matrix[y][x];
+u128_t part1(const worksheet_t& sheet)
+{
+    u128_t sum = 0;
+    int problem = 0;
+    for(char op : sheet.ops){
+        if(op == '+' || op == '*'){
+            sum += (op == '+') ? sheet.row_sums[problem] : sheet.row_products[problem];
+            problem++;
         }
-        sum += col_sum;
     }
     return sum;
 }
 
-size_t part2(problem_t& problem)
+u128_t part2(const worksheet_t& sheet)
 {
-    size_t sum = 0;
+    u128_t sum = 0;
     char op = '+';
-    size_t col_sum = 0;
-    for(int x=0; x<problem.width; ++x){
-        std::string num;
-        for(int y=0; y<problem.height; ++y){
-            num += problem(x, y);
-        }
-
-        if(num.back() == '+' || num.back() == '*'){
-            op = num.back();
+    u128_t col_sum = 0;
+    for(int x=0; x<sheet.column_numbers.size(); ++x){
+        char c = x < sheet.ops.size() ? sheet.ops[x] : ' ';
+        if(c == '+' || c == '*'){
+            op = c;
             sum += col_sum;
             col_sum = (op == '+') ? 0 : 1;
         }
 
-        if(num.find_first_not_of(' ') != std::string::npos){ // not only spaces
-            int inum = std::stoi(num);
-            col_sum = (op == '+') ? col_sum + inum : col_sum * inum;
+        if(sheet.has_digit[x]){
+            if(op == '+'){
+                col_sum += sheet.column_numbers[x];
+            }else{
+                col_sum *= sheet.column_numbers[x];
+            }
         }
     }
     sum += col_sum;
@@ -92,8 +203,8 @@ void main()
     auto actual_values = load_input("../src/day06/input.txt");
 
     std::cout << "part1: " << part1(test_values) << std::endl;
-    std::cout << "part1: " << part1(actual_values) << std::endl;
+    std::cout << "part1: " << bench("day06", "part1", [&]{ return part1(actual_values); }) << std::endl;
 
     std::cout << "part2: " << part2(test_values) << std::endl;
-    std::cout << "part2: " << part2(actual_values) << std::endl;
+    std::cout << "part2: " << bench("day06", "part2", [&]{ return part2(actual_values); }) << std::endl;
 }
\ No newline at end of file
@@ -2,12 +2,14 @@
 #include <fstream>
 #include <string>
 #include <vector>
-#include <unordered_map>
+#include <bitset>
+#include <algorithm>
+#include <cstdlib>
+#include <bench.hpp>
 
 struct pos_t {
     int x, y;
 };
-bool operator==(const pos_t& a, const pos_t& b){ return a.x == b.x && a.y == b.y; }
 
 struct grid_t {
     std::vector<char> data;
@@ -28,72 +30,176 @@ grid_t load_input(const std::string& file){
     return ret;
 }
 
-struct pos_hash{
-    std::size_t operator()(const pos_t& pos) const {
-        return (pos.x + pos.y + 1ull) * (pos.x + pos.y) / 2ull + pos.y; // cantor
+using bits_t = std::vector<uint64_t>; // bit x of word x/64 is column x
+
+int popcount(uint64_t v) {
+    return (int)std::bitset<64>(v).count();
+}
+
+void pack_row(const std::string& row, char c, bits_t& bits)
+{
+    std::fill(bits.begin(), bits.end(), 0);
+    for(int x=0; x<row.size(); ++x){
+        bits[x >> 6] |= (uint64_t)(row[x] == c) << (x & 63);
     }
-};
-using cache_t = std::unordered_map<pos_t, size_t, pos_hash>;
+}
 
-size_t travel(const pos_t& beam_pos, const grid_t& grid, cache_t& visited)
+// beams and splitters as bitsets, 64 columns per word operation
+size_t count_splits(std::istream& is)
 {
-    pos_t pos = { beam_pos.x, beam_pos.y + 1 };
-    if(pos.y == grid.height){ return 0; } // end of beam
-
-    if(grid(pos) == '^'){
-        size_t splits = 0;
-        bool can_split = false;
-
-        for(int dx : { -1, 1 }) {
-            pos_t new_pos { pos.x + dx, pos.y };
-            if(!visited.count(new_pos)) {
-                visited[new_pos] = 1;
-                splits += travel(new_pos, grid, visited);
-                can_split = true;
-            }
+    size_t splits = 0;
+    bits_t beams, splitters, split;
+    std::string row;
+
+    while (std::getline(is, row)) {
+        int words = ((int)row.size() + 63) / 64;
+        if(beams.empty()){
+            beams.assign(words, 0);
+            splitters.assign(words, 0);
+            split.assign(words, 0);
+        }
+
+        pack_row(row, 'S', splitters);
+        for(int w=0; w<words; ++w){
+            beams[w] |= splitters[w];
+        }
+
+        pack_row(row, '^', splitters);
+        for(int w=0; w<words; ++w){
+            split[w] = beams[w] & splitters[w];
+            splits += popcount(split[w]);
+        }
+
+        for(int w=0; w<words; ++w){
+            uint64_t left = (split[w] >> 1) | (w+1 < words ? split[w+1] << 63 : 0);
+            uint64_t right = (split[w] << 1) | (w > 0 ? split[w-1] >> 63 : 0);
+            beams[w] = (beams[w] & ~split[w]) | left | right;
         }
 
-        return splits + can_split;
+        if(row.size() % 64){
+            beams[words-1] &= ~0ull >> (64 - row.size() % 64);
+        }
     }
-    visited[pos] = 1;
-    return travel(pos, grid, visited);
+
+    return splits;
 }
 
-size_t part1(const grid_t& grid)
+// one row at a time, timelines[x] is the number of timelines with a beam in column x
+uint64_t count_timelines(std::istream& is)
 {
-    pos_t start_pos { (int)std::distance(grid.data.begin(), std::find(grid.data.begin(), grid.data.end(), 'S')), 0 };
-    return travel(start_pos, grid, cache_t());
+    std::vector<uint64_t> timelines;
+    std::string row;
+
+    while (std::getline(is, row)) {
+        if(timelines.empty()){
+            timelines.assign(row.size(), 0);
+        }
+
+        uint64_t from_left = 0;
+        for(int x=0; x<row.size(); ++x){
+            uint64_t count = timelines[x];
+            if(row[x] == 'S'){
+                count++;
+            }
+
+            bool split = row[x] == '^' && count;
+            if(split && x > 0){
+                timelines[x-1] += count;
+            }
+            timelines[x] = (split ? 0 : count) + from_left;
+            from_left = split ? count : 0;
+        }
+    }
+
+    uint64_t sum = 0;
+    for(uint64_t count : timelines){
+        sum += count;
+    }
+    return sum;
 }
 
-size_t timeline_travel(const pos_t& beam_pos, const grid_t& grid, cache_t& cache)
+struct timeline_table_t {
+    std::vector<uint64_t> counts; // timelines for a beam starting at (x, y), as if 'S' were there
+    int width = 0;
+    int height = 0;
+    uint64_t operator()(const pos_t& p) const { return counts[p.y*width + p.x]; }
+};
+
+// bottom up, each row only reads the row below it
+timeline_table_t build_timeline_table(const grid_t& grid)
 {
-    pos_t pos = { beam_pos.x, beam_pos.y+1 };
-    if(pos.y == grid.height){ return 1; } // end of beam
+    timeline_table_t table { std::vector<uint64_t>((size_t)grid.width * grid.height, 1), grid.width, grid.height };
+
+    for(int y=grid.height-2; y>=0; --y){
+        const uint64_t* below = &table.counts[(size_t)(y+1) * grid.width];
+        uint64_t* row = &table.counts[(size_t)y * grid.width];
 
-    if(grid(pos) == '^'){
-        if(cache.count(pos)){
-            return cache[pos];
+        for(int x=0; x<grid.width; ++x){
+            if(grid({ x, y+1 }) == '^'){
+                row[x] = (x > 0 ? below[x-1] : 0) + (x+1 < grid.width ? below[x+1] : 0);
+            }else{
+                row[x] = below[x];
+            }
         }
-        cache[pos] = timeline_travel({ pos.x-1, pos.y }, grid, cache) + timeline_travel({ pos.x+1, pos.y }, grid, cache);
-        return cache[pos];
     }
-    return timeline_travel(pos, grid, cache);
+
+    return table;
+}
+
+std::vector<uint64_t> query_timelines(const timeline_table_t& table, const std::vector<pos_t>& starts)
+{
+    std::vector<uint64_t> ret;
+    ret.reserve(starts.size());
+    for(auto& start : starts){
+        ret.push_back(table(start));
+    }
+    return ret;
+}
+
+size_t part1(const std::string& file)
+{
+    std::ifstream fs(file);
+    return count_splits(fs);
 }
 
-size_t part2(const grid_t& grid)
+size_t part2(const std::string& file)
 {
-    pos_t start_pos { (int)std::distance(grid.data.begin(), std::find(grid.data.begin(), grid.data.end(), 'S')), 0 };
-    return timeline_travel(start_pos, grid, cache_t());
+    std::ifstream fs(file);
+    return count_timelines(fs);
+}
+
+// the table entry at 'S' is part2's answer, reached bottom up instead of streaming down
+bool check_timeline_table(const std::string& file)
+{
+    auto grid = load_input(file);
+    auto table = build_timeline_table(grid);
+
+    std::vector<pos_t> starts;
+    for(int i=0; i<grid.data.size(); ++i){
+        if(grid.data[i] == 'S'){
+            starts.push_back({ i % grid.width, i / grid.width });
+        }
+    }
+
+    uint64_t sum = 0;
+    for(uint64_t timelines : query_timelines(table, starts)){
+        sum += timelines;
+    }
+    return sum == part2(file);
 }
 
 void main()
 {
-    auto test_values = load_input("../src/day07/test_input.txt");
-    auto actual_values = load_input("../src/day07/input.txt");
+    std::string test_file = "../src/day07/test_input.txt";
+    std::string actual_file = "../src/day07/input.txt";
+
+    std::cout << "part1: " << part1(test_file) << std::endl;
+    std::cout << "part1: " << bench("day07", "part1", [&]{ return part1(actual_file); }) << std::endl;
 
-    std::cout << "part1: " << part1(test_values) << std::endl;
-    std::cout << "part1: " << part1(actual_values) << std::endl;
+    std::cout << "part2: " << part2(test_file) << std::endl;
+    std::cout << "part2: " << bench("day07", "part2", [&]{ return part2(actual_file); }) << std::endl;
 
-    std::cout << "part2: " << part2(test_values) << std::endl;
-    std::cout << "part2: " << part2(actual_values) << std::endl;
+    if(std::getenv("AOC_SELF_CHECK")){
+        std::cout << "timeline table check: " << (check_timeline_table(test_file) && check_timeline_table(actual_file) ? "ok" : "FAILED") << std::endl;
+    }
 }
\ No newline at end of file
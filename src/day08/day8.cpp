@@ -3,6 +3,21 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <charconv>
+#include <string_view>
+#include <array>
+#include <set>
+#include <queue>
+#include <random>
+#include <numeric>
+#include <functional>
+#include <cmath>
+#include <tuple>
+#include <cstdlib>
+#include <line_stream.hpp>
+#include <flat_hash.hpp>
+#include <small_vector.hpp>
+#include <bench.hpp>
 
 struct box_t {
     int64_t x, y, z;
@@ -11,15 +26,25 @@ box_t operator-(const box_t& a, const box_t& b){ return { a.x-b.x, a.y-b.y, a.z-
 
 using boxes_t = std::vector<box_t>;
 
+// the boxes are the solver's state so they are kept, but parsing overlaps the reads without a string per line
 boxes_t load_input(const std::string& file){
     boxes_t ret;
-    std::ifstream fs(file);
-    std::string line;
-    while (std::getline(fs, line)) {
-        int x, y, z;
-        sscanf_s(line.c_str(), "%d,%d,%d\n", &x, &y, &z); 
-        ret.push_back({ x, y, z });
-    }
+    line_stream stream(file);
+    stream.for_each_line([&](std::string_view line){
+        if(line.empty()){
+            return;
+        }
+        int64_t v[3] = {};
+        const char* p = line.data();
+        const char* end = line.data() + line.size();
+        for(int i=0; i<3; ++i){
+            p = std::from_chars(p, end, v[i]).ptr;
+            if(p < end){
+                ++p; // ','
+            }
+        }
+        ret.push_back({ v[0], v[1], v[2] });
+    });
     return ret;
 }
 
@@ -28,10 +53,11 @@ int64_t sq_dist(const box_t& a, const box_t& b){
     return c.x*c.x + c.y*c.y + c.z*c.z;
 }
 
+// pairs of equal length are taken in index order, so "the first k pairs" and "the last connection" are well defined
 struct edge_t {
     int a, b;
     int64_t dist;
-    bool operator<(const edge_t& right) const { return dist < right.dist; }
+    bool operator<(const edge_t& right) const { return std::tie(dist, a, b) < std::tie(right.dist, right.a, right.b); }
 };
 
 struct dsu_t {
@@ -76,8 +102,15 @@ size_t part1(const boxes_t& boxes, int pair_count)
         dsu.uunion(edges[i].a, edges[i].b);
     }
 
-    std::partial_sort(dsu.size.begin(), dsu.size.begin()+3, dsu.size.end(), std::greater<int>());
-    return dsu.size[0] * dsu.size[1] * dsu.size[2];
+    std::vector<int> sizes; // only roots, the others keep the size they had when they were merged away
+    for(int i=0; i<boxes.size(); ++i) {
+        if(dsu.find(i) == i) {
+            sizes.push_back(dsu.size[i]);
+        }
+    }
+    sizes.resize(std::max<size_t>(sizes.size(), 3), 1);
+    std::partial_sort(sizes.begin(), sizes.begin()+3, sizes.end(), std::greater<int>());
+    return (size_t)sizes[0] * sizes[1] * sizes[2];
 }
 
 size_t part2(const boxes_t& boxes)
@@ -105,14 +138,793 @@ size_t part2(const boxes_t& boxes)
     return boxes[edge.a].x * boxes[edge.b].x;
 }
 
+// spanning tree edges order by length and then by the tags of their ends, lower tag first, which matches edge_t
+// when the tags are input indices. with no two edges equal the spanning tree is unique
+struct edge_key_t {
+    int64_t dist, lo, hi;
+
+    static edge_key_t of(int64_t dist, int64_t tag_a, int64_t tag_b) { return { dist, std::min(tag_a, tag_b), std::max(tag_a, tag_b) }; }
+
+    bool operator<(const edge_key_t& right) const { return std::tie(dist, lo, hi) < std::tie(right.dist, right.lo, right.hi); }
+    bool operator<=(const edge_key_t& right) const { return !(right < *this); }
+};
+
+// link-cut trees over point and edge nodes. an edge is a node of its own between its two endpoints so a path
+// carries edge weights: one access gives the heaviest edge on a path, and through the point counts of virtual
+// children, the number of points in a whole tree
+class link_cut_forest
+{
+public:
+    static constexpr edge_key_t none = { -1, -1, -1 }; // weight of point nodes, below every edge
+
+    int add(edge_key_t weight, int points, int tag) {
+        int x;
+        if(!free_.empty()){
+            x = free_.back();
+            free_.pop_back();
+            nodes_[x] = node_t();
+        }else{
+            x = (int)nodes_.size();
+            nodes_.emplace_back();
+        }
+        nodes_[x].weight = weight;
+        nodes_[x].points = points;
+        nodes_[x].tag = tag;
+        pull(x);
+        return x;
+    }
+
+    // x must already be cut from everything
+    void remove(int x) { free_.push_back(x); }
+
+    const edge_key_t& weight(int x) const { return nodes_[x].weight; }
+    int tag(int x) const { return nodes_[x].tag; }
+
+    // a and b in different trees
+    void link(int a, int b) {
+        make_root(a);
+        access(b);
+        nodes_[a].parent = b;
+        nodes_[b].virt += nodes_[a].sum;
+        pull(b);
+    }
+
+    // a and b adjacent
+    void cut(int a, int b) {
+        make_root(a);
+        access(b);
+        nodes_[b].ch[0] = -1;
+        nodes_[a].parent = -1;
+        pull(b);
+    }
+
+    bool connected(int a, int b) { return find_root(a) == find_root(b); }
+
+    // the heaviest node on the path from a to b, a and b connected
+    int path_max(int a, int b) {
+        make_root(a);
+        access(b);
+        return nodes_[b].best;
+    }
+
+    int64_t tree_points(int x) {
+        access(x);
+        return nodes_[x].sum;
+    }
+
+private:
+    struct node_t {
+        int ch[2] = { -1, -1 };
+        int parent = -1; // splay parent, or path parent when x is the root of its splay tree
+        bool flip = false;
+        edge_key_t weight = none;
+        int best = -1; // heaviest node in the splay subtree
+        int points = 0;
+        int tag = -1;
+        int64_t virt = 0; // points hanging off x through path parents
+        int64_t sum = 0;  // points in the splay subtree and everything hanging off it
+    };
+
+    bool is_root(int x) const {
+        int p = nodes_[x].parent;
+        return p < 0 || (nodes_[p].ch[0] != x && nodes_[p].ch[1] != x);
+    }
+
+    void push(int x) {
+        auto& n = nodes_[x];
+        if(n.flip){
+            std::swap(n.ch[0], n.ch[1]);
+            for(int c : n.ch){
+                if(c >= 0){
+                    nodes_[c].flip = !nodes_[c].flip;
+                }
+            }
+            n.flip = false;
+        }
+    }
+
+    void pull(int x) {
+        auto& n = nodes_[x];
+        n.best = x;
+        n.sum = n.points + n.virt;
+        for(int c : n.ch){
+            if(c >= 0){
+                n.sum += nodes_[c].sum;
+                if(nodes_[n.best].weight < nodes_[nodes_[c].best].weight){
+                    n.best = nodes_[c].best;
+                }
+            }
+        }
+    }
+
+    void rotate(int x) {
+        int p = nodes_[x].parent;
+        int g = nodes_[p].parent;
+        int dir = nodes_[p].ch[1] == x;
+        int b = nodes_[x].ch[!dir];
+
+        if(!is_root(p)){
+            nodes_[g].ch[nodes_[g].ch[1] == p] = x;
+        }
+        nodes_[x].parent = g;
+
+        nodes_[p].ch[dir] = b;
+        if(b >= 0){
+            nodes_[b].parent = p;
+        }
+        nodes_[x].ch[!dir] = p;
+        nodes_[p].parent = x;
+
+        pull(p);
+        pull(x);
+    }
+
+    void splay(int x) {
+        path_.clear();
+        for(int y=x; ; y=nodes_[y].parent){
+            path_.push_back(y);
+            if(is_root(y)){
+                break;
+            }
+        }
+        for(auto it=path_.rbegin(); it!=path_.rend(); ++it){
+            push(*it);
+        }
+
+        while(!is_root(x)){
+            int p = nodes_[x].parent;
+            if(!is_root(p)){
+                int g = nodes_[p].parent;
+                bool zigzig = (nodes_[g].ch[0] == p) == (nodes_[p].ch[0] == x);
+                rotate(zigzig ? p : x);
+            }
+            rotate(x);
+        }
+    }
+
+    void access(int x) {
+        for(int last=-1, y=x; y>=0; last=y, y=nodes_[y].parent){
+            splay(y);
+            auto& n = nodes_[y];
+            if(n.ch[1] >= 0){
+                n.virt += nodes_[n.ch[1]].sum;
+            }
+            if(last >= 0){
+                n.virt -= nodes_[last].sum;
+            }
+            n.ch[1] = last;
+            pull(y);
+        }
+        splay(x);
+    }
+
+    void make_root(int x) {
+        access(x);
+        nodes_[x].flip = !nodes_[x].flip;
+    }
+
+    int find_root(int x) {
+        access(x);
+        while(true){
+            push(x);
+            if(nodes_[x].ch[0] < 0){
+                break;
+            }
+            x = nodes_[x].ch[0];
+        }
+        splay(x);
+        return x;
+    }
+
+    std::vector<node_t> nodes_;
+    std::vector<int> free_;
+    std::vector<int> path_;
+};
+
+struct tree_edge_t {
+    int a, b;
+    edge_key_t key;
+    int tree_node;
+    int near_node; // -1 unless the edge is within the near distance
+};
+
+// the euclidean minimum spanning tree of a changing set of boxes plus the circuits formed by every pair up to a
+// near limit. the connection that finally joins everything in part2 is the last spanning tree edge, and the part1
+// circuits are the trees left after dropping the spanning tree edges past the near limit. boxes carry a tag that
+// orders equal lengths, see edge_key_t
+//
+// an insert only offers the new box its nearest neighbour in each of 54 cones narrower than 60 degrees, any other
+// box is closer to one of those than to the new box so its edge can't be needed. an erase cuts the box's edges
+// and reconnects the pieces boruvka style with nearest-other-piece searches, skipping the largest piece. the
+// tree changes through link-cut swaps in O(log n), the searches cost what the grid cells around them hold
+class online_circuits_t
+{
+public:
+    // cell is the side of the grid cells, about the typical spacing of the boxes
+    online_circuits_t(int64_t cell, edge_key_t near_limit = link_cut_forest::none) : cell_(std::max<int64_t>(cell, 1)), near_limit_(near_limit) {}
+
+    int insert(const box_t& box, int64_t tag)
+    {
+        int id;
+        if(!free_ids_.empty()){
+            id = free_ids_.back();
+            free_ids_.pop_back();
+        }else{
+            id = (int)boxes_.size();
+            boxes_.emplace_back();
+            tags_.push_back(0);
+            tree_node_.push_back(-1);
+            near_node_.push_back(-1);
+            adjacency_.emplace_back();
+            label_.push_back(-1);
+            stamp_.push_back(0);
+        }
+
+        boxes_[id] = box;
+        tags_[id] = tag;
+        tree_node_[id] = tree_.add(link_cut_forest::none, 1, id);
+        near_node_[id] = near_forest_.add(link_cut_forest::none, 1, id);
+        adjacency_[id].clear();
+        circuit_sizes_.insert(1);
+
+        std::array<bool, cones> closed {};
+        int open = cones;
+        std::vector<std::pair<int, int64_t>> candidates;
+        nearest_first(box, [&](int q, int64_t dist){
+            int c = cone_of(boxes_[q] - box);
+            if(!closed[c]){
+                closed[c] = true;
+                open--;
+                candidates.push_back({ q, dist });
+            }
+            return open > 0;
+        });
+
+        grid_add(id);
+        for(auto [q, dist] : candidates){
+            offer(id, q, edge_key_t::of(dist, tag, tags_[q]));
+        }
+
+        live_++;
+        return id;
+    }
+
+    void erase(int id)
+    {
+        std::vector<int> pieces;
+        auto incident = adjacency_[id];
+        for(int e : incident){
+            pieces.push_back(edges_[e].a == id ? edges_[e].b : edges_[e].a);
+            unlink(e);
+        }
+
+        grid_remove(id);
+        erase_size(1);
+        tree_.remove(tree_node_[id]);
+        near_forest_.remove(near_node_[id]);
+        tree_node_[id] = near_node_[id] = -1;
+        free_ids_.push_back(id);
+        live_--;
+
+        reconnect(pieces);
+    }
+
+    size_t size() const { return live_; }
+    const box_t& box(int id) const { return boxes_[id]; }
+
+    // edges up to limit count for the circuits from now on
+    void set_near_limit(edge_key_t limit) {
+        near_limit_ = limit;
+        for(int e : live_edges()){
+            bool near = edges_[e].key <= limit;
+            if(near && edges_[e].near_node < 0){
+                mirror(e);
+            }else if(!near && edges_[e].near_node >= 0){
+                unmirror(e);
+            }
+        }
+    }
+
+    // the k-th of all pairs in edge_key_t order, or the last pair when there are fewer. every box searches out
+    // from itself for partners with a higher tag, stopping at the current k-th, so with a near limit the work is
+    // about the pairs within it
+    edge_key_t kth_closest_pair(size_t k) const {
+        std::priority_queue<edge_key_t> best; // the k smallest so far, largest on top
+        for(int p=0; p<boxes_.size(); ++p){
+            if(tree_node_[p] < 0){
+                continue;
+            }
+            nearest_first(boxes_[p], [&](int q, int64_t dist){
+                if(best.size() == k && best.top().dist < dist){
+                    return false;
+                }
+                if(tags_[q] <= tags_[p]){
+                    return true;
+                }
+                auto key = edge_key_t::of(dist, tags_[p], tags_[q]);
+                if(best.size() < k){
+                    best.push(key);
+                }else if(key < best.top()){
+                    best.pop();
+                    best.push(key);
+                }
+                return true;
+            });
+        }
+        return best.empty() ? link_cut_forest::none : best.top();
+    }
+
+    // last edge of the spanning tree, nullptr below two boxes
+    const tree_edge_t* bottleneck() const {
+        return by_key_.empty() ? nullptr : &edges_[by_key_.rbegin()->second];
+    }
+
+    // sizes of the k largest circuits, largest first
+    std::vector<int64_t> largest_circuits(int k) const {
+        std::vector<int64_t> ret;
+        for(auto it=circuit_sizes_.rbegin(); it!=circuit_sizes_.rend() && (int)ret.size()<k; ++it){
+            ret.push_back(*it);
+        }
+        return ret;
+    }
+
+private:
+    static constexpr int cones = 54; // 6 cube faces split 3x3, widest cone is about 50.5 degrees
+
+    static int cone_of(const box_t& v) {
+        int64_t a[3] = { v.x, v.y, v.z };
+        int axis = 0;
+        for(int i=1; i<3; ++i){
+            if(std::abs(a[i]) > std::abs(a[axis])){
+                axis = i;
+            }
+        }
+
+        int64_t major = std::abs(a[axis]);
+        auto third = [&](int64_t minor){ return 3*minor < -major ? 0 : 3*minor > major ? 2 : 1; };
+        int face = axis * 2 + (a[axis] < 0);
+        return face * 9 + third(a[(axis+1) % 3]) * 3 + third(a[(axis+2) % 3]);
+    }
+
+    // a new edge joins two trees or replaces the longest edge on the cycle it closes, if that one is longer
+    void offer(int a, int b, edge_key_t key)
+    {
+        if(tree_.connected(tree_node_[a], tree_node_[b])){
+            int worst = tree_.path_max(tree_node_[a], tree_node_[b]);
+            if(tree_.weight(worst) < key){
+                return;
+            }
+            unlink(tree_.tag(worst));
+        }
+        link(a, b, key);
+    }
+
+    void link(int a, int b, edge_key_t key)
+    {
+        int e;
+        if(!free_edges_.empty()){
+            e = free_edges_.back();
+            free_edges_.pop_back();
+        }else{
+            e = (int)edges_.size();
+            edges_.emplace_back();
+        }
+
+        int node = tree_.add(key, 0, e);
+        tree_.link(tree_node_[a], node);
+        tree_.link(node, tree_node_[b]);
+        edges_[e] = { a, b, key, node, -1 };
+        by_key_.insert({ key, e });
+        adjacency_[a].push_back(e);
+        adjacency_[b].push_back(e);
+
+        if(key <= near_limit_){
+            mirror(e);
+        }
+    }
+
+    void mirror(int e)
+    {
+        auto& edge = edges_[e];
+        erase_size(near_forest_.tree_points(near_node_[edge.a]));
+        erase_size(near_forest_.tree_points(near_node_[edge.b]));
+        edge.near_node = near_forest_.add(link_cut_forest::none, 0, e);
+        near_forest_.link(near_node_[edge.a], edge.near_node);
+        near_forest_.link(edge.near_node, near_node_[edge.b]);
+        circuit_sizes_.insert(near_forest_.tree_points(near_node_[edge.a]));
+    }
+
+    void unmirror(int e)
+    {
+        auto& edge = edges_[e];
+        erase_size(near_forest_.tree_points(near_node_[edge.a]));
+        near_forest_.cut(near_node_[edge.a], edge.near_node);
+        near_forest_.cut(edge.near_node, near_node_[edge.b]);
+        near_forest_.remove(edge.near_node);
+        edge.near_node = -1;
+        circuit_sizes_.insert(near_forest_.tree_points(near_node_[edge.a]));
+        circuit_sizes_.insert(near_forest_.tree_points(near_node_[edge.b]));
+    }
+
+    std::vector<int> live_edges() const {
+        std::vector<int> ret;
+        for(auto& [key, e] : by_key_){
+            ret.push_back(e);
+        }
+        return ret;
+    }
+
+    void unlink(int e)
+    {
+        if(edges_[e].near_node >= 0){
+            unmirror(e);
+        }
+
+        auto edge = edges_[e];
+        tree_.cut(tree_node_[edge.a], edge.tree_node);
+        tree_.cut(edge.tree_node, tree_node_[edge.b]);
+        tree_.remove(edge.tree_node);
+        by_key_.erase({ edge.key, e });
+
+        for(int end : { edge.a, edge.b }){
+            auto& adj = adjacency_[end];
+            auto it = std::find(adj.begin(), adj.end(), e);
+            *it = adj.back();
+            adj.pop_back();
+        }
+
+        free_edges_.push_back(e);
+    }
+
+    void erase_size(int64_t size) { circuit_sizes_.erase(circuit_sizes_.find(size)); }
+
+    // pieces left by an erase, one per cut edge. every piece but the largest is labelled by growing all of them
+    // in turns until one is left, then each group of pieces adds its shortest edge to another group until one
+    // group remains. the old tree edges all stay, nothing across a piece boundary can be shorter than those
+    void reconnect(const std::vector<int>& pieces)
+    {
+        int m = (int)pieces.size();
+        if(m < 2){
+            return;
+        }
+
+        stamp_counter_++;
+        auto piece_of = [&](int q, int rest){ return stamp_[q] == stamp_counter_ ? label_[q] : rest; };
+
+        std::vector<std::vector<int>> members(m);
+        std::vector<size_t> heads(m, 0);
+        for(int i=0; i<m; ++i){
+            members[i].push_back(pieces[i]);
+            label_[pieces[i]] = i;
+            stamp_[pieces[i]] = stamp_counter_;
+        }
+
+        int growing = m;
+        std::vector<bool> done(m, false);
+        while(growing > 1){
+            for(int i=0; i<m && growing>1; ++i){
+                if(done[i]){
+                    continue;
+                }
+                if(heads[i] == members[i].size()){
+                    done[i] = true;
+                    growing--;
+                    continue;
+                }
+                int q = members[i][heads[i]++];
+                for(int e : adjacency_[q]){
+                    int r = edges_[e].a == q ? edges_[e].b : edges_[e].a;
+                    if(stamp_[r] != stamp_counter_){
+                        stamp_[r] = stamp_counter_;
+                        label_[r] = i;
+                        members[i].push_back(r);
+                    }
+                }
+            }
+        }
+        int rest = (int)(std::find(done.begin(), done.end(), false) - done.begin());
+
+        std::vector<int> group(m);
+        std::iota(group.begin(), group.end(), 0);
+        std::function<int(int)> find = [&](int g){ return group[g] == g ? g : group[g] = find(group[g]); };
+
+        struct best_t {
+            edge_key_t key = { INT64_MAX, INT64_MAX, INT64_MAX };
+            int a = -1, b = -1;
+        };
+
+        int groups = m;
+        while(groups > 1)
+        {
+            std::vector<best_t> best(m);
+            for(int i=0; i<m; ++i){
+                int g = find(i);
+                if(g == find(rest)){
+                    continue;
+                }
+                for(int q : members[i]){
+                    nearest_first(boxes_[q], [&](int r, int64_t dist){
+                        auto key = edge_key_t::of(dist, tags_[q], tags_[r]);
+                        if(best[g].key <= key){
+                            return false;
+                        }
+                        if(find(piece_of(r, rest)) == g){
+                            return true;
+                        }
+                        best[g] = { key, q, r };
+                        return false;
+                    });
+                }
+            }
+
+            for(int g=0; g<m; ++g){
+                if(best[g].a < 0){
+                    continue;
+                }
+                offer(best[g].a, best[g].b, best[g].key);
+                int from = find(g), to = find(piece_of(best[g].b, rest));
+                if(from != to){
+                    group[from] = to;
+                    groups--;
+                }
+            }
+        }
+    }
+
+    std::array<int64_t, 3> cell_of(const box_t& box) const {
+        auto floor_div = [&](int64_t v){ return v >= 0 ? v / cell_ : -((-v + cell_ - 1) / cell_); };
+        return { floor_div(box.x), floor_div(box.y), floor_div(box.z) };
+    }
+
+    static uint64_t cell_key(int64_t x, int64_t y, int64_t z) {
+        const int64_t bias = 1 << 20;
+        return (uint64_t)((x + bias) & 0x1fffff) << 42 | (uint64_t)((y + bias) & 0x1fffff) << 21 | (uint64_t)((z + bias) & 0x1fffff);
+    }
+
+    void grid_add(int id) {
+        auto c = cell_of(boxes_[id]);
+        cells_[cell_key(c[0], c[1], c[2])].push_back(id);
+        for(int i=0; i<3; ++i){
+            lo_[i] = live_ ? std::min(lo_[i], c[i]) : c[i];
+            hi_[i] = live_ ? std::max(hi_[i], c[i]) : c[i];
+        }
+    }
+
+    void grid_remove(int id) {
+        auto c = cell_of(boxes_[id]);
+        uint64_t key = cell_key(c[0], c[1], c[2]);
+        auto& cell = cells_[key];
+        auto it = std::find(cell.begin(), cell.end(), id);
+        *it = cell.back();
+        cell.pop_back();
+        if(cell.empty()){
+            cells_.erase(key);
+        }
+    }
+
+    // visit(id, squared distance) on boxes in order of distance from center until it returns false. ring k of
+    // cells around center's cell is at least (k-1) cells away, so once ring k is in everything within k cells
+    // is final. equal distances go by tag, for a fixed center that is edge_key_t order
+    template<typename F>
+    void nearest_first(const box_t& center, F&& visit) const
+    {
+        if(!live_){
+            return;
+        }
+
+        auto c = cell_of(center);
+        int64_t max_ring = 0;
+        for(int i=0; i<3; ++i){
+            max_ring = std::max({ max_ring, c[i] - lo_[i], hi_[i] - c[i] });
+        }
+
+        using entry_t = std::tuple<int64_t, int64_t, int>; // distance, tag, id
+        std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> pending;
+
+        auto add_cell = [&](int64_t x, int64_t y, int64_t z){
+            auto it = cells_.find(cell_key(x, y, z));
+            if(it != cells_.end()){
+                for(int id : it->second){
+                    pending.push({ sq_dist(center, boxes_[id]), tags_[id], id });
+                }
+            }
+        };
+
+        for(int64_t k=0; k<=max_ring; ++k)
+        {
+            // past this ring the cells are mostly empty, the occupied ones are fewer than the lookups
+            if(24*k*k + 2 > (int64_t)cells_.size()){
+                for(auto& [key, ids] : cells_){
+                    for(int id : ids){
+                        auto d = cell_of(boxes_[id]);
+                        if(std::max({ std::abs(d[0]-c[0]), std::abs(d[1]-c[1]), std::abs(d[2]-c[2]) }) >= k){
+                            pending.push({ sq_dist(center, boxes_[id]), tags_[id], id });
+                        }
+                    }
+                }
+                break;
+            }
+
+            for(int64_t dx=-k; dx<=k; ++dx){
+                for(int64_t dy=-k; dy<=k; ++dy){
+                    if(std::abs(dx) == k || std::abs(dy) == k){
+                        for(int64_t dz=-k; dz<=k; ++dz){
+                            add_cell(c[0]+dx, c[1]+dy, c[2]+dz);
+                        }
+                    }else{
+                        add_cell(c[0]+dx, c[1]+dy, c[2]-k);
+                        add_cell(c[0]+dx, c[1]+dy, c[2]+k);
+                    }
+                }
+            }
+
+            int64_t reach = k * cell_;
+            while(!pending.empty() && std::get<0>(pending.top()) <= reach * reach){
+                auto [dist, tag, id] = pending.top();
+                pending.pop();
+                if(!visit(id, dist)){
+                    return;
+                }
+            }
+        }
+
+        while(!pending.empty()){
+            auto [dist, tag, id] = pending.top();
+            pending.pop();
+            if(!visit(id, dist)){
+                return;
+            }
+        }
+    }
+
+    int64_t cell_;
+    edge_key_t near_limit_;
+
+    std::vector<box_t> boxes_;
+    std::vector<int64_t> tags_;
+    std::vector<int> free_ids_;
+    size_t live_ = 0;
+
+    flat_hash_map<uint64_t, std::vector<int>> cells_;
+    std::array<int64_t, 3> lo_ {}, hi_ {};
+
+    link_cut_forest tree_, near_forest_; // the spanning tree, and its edges within the near distance
+    std::vector<int> tree_node_, near_node_;
+    std::vector<small_vector<int, 6>> adjacency_; // spanning tree edges per box
+    std::vector<tree_edge_t> edges_;
+    std::vector<int> free_edges_;
+    std::set<std::pair<edge_key_t, int>> by_key_;
+    std::multiset<int64_t> circuit_sizes_;
+
+    std::vector<int> label_;
+    std::vector<int> stamp_;
+    int stamp_counter_ = 0;
+};
+
+// grid cell side for about one box per cell over the bounding box
+int64_t cell_size(const boxes_t& boxes)
+{
+    box_t lo = boxes[0], hi = boxes[0];
+    for(auto& box : boxes){
+        lo = { std::min(lo.x, box.x), std::min(lo.y, box.y), std::min(lo.z, box.z) };
+        hi = { std::max(hi.x, box.x), std::max(hi.y, box.y), std::max(hi.z, box.z) };
+    }
+    double volume = (double)(hi.x - lo.x + 1) * (hi.y - lo.y + 1) * (hi.z - lo.z + 1);
+    return std::max<int64_t>(1, (int64_t)std::cbrt(volume / boxes.size()));
+}
+
+// the boxes arrive one at a time tagged with their index, then a quarter of them are taken out and put back in
+// random order. the tree has to end up the same as the batch one
+online_circuits_t stream_in(const boxes_t& boxes)
+{
+    online_circuits_t circuits(cell_size(boxes));
+    std::vector<int> ids;
+    for(int i=0; i<boxes.size(); ++i){
+        ids.push_back(circuits.insert(boxes[i], i));
+    }
+
+    std::mt19937 rng(8);
+    std::vector<int> order(boxes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+    order.resize(boxes.size() / 4);
+
+    for(int i : order){
+        circuits.erase(ids[i]);
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    for(int i : order){
+        ids[i] = circuits.insert(boxes[i], i);
+    }
+    return circuits;
+}
+
+// part1 links the first pair_count pairs, the same circuits as keeping the spanning tree edges up to the last of them
+size_t part1_online(const boxes_t& boxes, int pair_count)
+{
+    auto circuits = stream_in(boxes);
+    circuits.set_near_limit(circuits.kth_closest_pair(pair_count));
+
+    auto sizes = circuits.largest_circuits(3);
+    sizes.resize(3, 1);
+    return (size_t)(sizes[0] * sizes[1] * sizes[2]);
+}
+
+size_t part2_online(const boxes_t& boxes)
+{
+    auto circuits = stream_in(boxes);
+    auto edge = circuits.bottleneck();
+    return circuits.box(edge->a).x * circuits.box(edge->b).x;
+}
+
+// lattices, every spanning tree edge has the same length as many others, scrambled so index order is not
+// lattice order. both parts have to agree between the batch and online paths for several pair counts
+bool check_ties()
+{
+    std::mt19937 rng(80);
+    for(int side=2; side<=7; ++side)
+    {
+        boxes_t boxes;
+        for(int x=0; x<side; ++x){
+            for(int y=0; y<side; ++y){
+                for(int z=0; z<side+1; ++z){
+                    boxes.push_back({ 10 + 3*x, 20 + 3*y, 30 + 3*z });
+                }
+            }
+        }
+        std::shuffle(boxes.begin(), boxes.end(), rng);
+
+        int pairs = (int)(boxes.size() * (boxes.size()-1) / 2);
+        for(int pair_count : { 1, (int)boxes.size() / 2, (int)boxes.size(), 2 * (int)boxes.size(), pairs }){
+            if(part1(boxes, pair_count) != part1_online(boxes, pair_count)){
+                return false;
+            }
+        }
+        if(part2(boxes) != part2_online(boxes)){
+            return false;
+        }
+    }
+    return true;
+}
+
 void main()
 {
     auto test_values = load_input("../src/day08/test_input.txt");
     auto actual_values = load_input("../src/day08/input.txt");
 
     std::cout << "part1: " << part1(test_values, 10) << std::endl;
-    std::cout << "part1: " << part1(actual_values, 1000) << std::endl;
+    std::cout << "part1: " << bench("day08", "part1", [&]{ return part1(actual_values, 1000); }) << std::endl;
 
     std::cout << "part2: " << part2(test_values) << std::endl;
-    std::cout << "part2: " << part2(actual_values) << std::endl;
+    std::cout << "part2: " << bench("day08", "part2", [&]{ return part2(actual_values); }) << std::endl;
+
+    std::cout << "part1 online: " << part1_online(test_values, 10) << std::endl;
+    std::cout << "part1 online: " << bench("day08", "part1_online", [&]{ return part1_online(actual_values, 1000); }) << std::endl;
+
+    std::cout << "part2 online: " << part2_online(test_values) << std::endl;
+    std::cout << "part2 online: " << bench("day08", "part2_online", [&]{ return part2_online(actual_values); }) << std::endl;
+
+    if(std::getenv("AOC_SELF_CHECK")){
+        std::cout << "tied distances: " << (check_ties() ? "batch and online agree" : "batch and online DIFFER") << std::endl;
+    }
 }
\ No newline at end of file
@@ -2,6 +2,9 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <bench.hpp>
+#include <thread_pool.hpp>
 
 struct tile_t {
     int64_t x, y;
@@ -25,15 +28,18 @@ int64_t area(const tile_t& a, const tile_t& b){
     return (std::abs(b.x-a.x)+1) * (std::abs(b.y-a.y)+1);
 }
 
+auto max_area = [](int64_t a, int64_t b){ return std::max(a, b); };
+
+// one task per first tile of the pair, later tiles have fewer partners so they are handed out one at a time
 int64_t part1(const tiles_t& tiles)
 {
-    int64_t largest_area = 0;
-    for(int i=0; i<tiles.size(); ++i){
+    return parallel_reduce(0, (int)tiles.size(), int64_t(0), [&](int i){
+        int64_t largest_area = 0;
         for(int j=i+1; j<tiles.size(); ++j){
             largest_area = std::max(largest_area, area(tiles[i], tiles[j]));
         }
-    }
-    return largest_area;
+        return largest_area;
+    }, max_area);
 }
 
 int64_t orient(const tile_t& a, const tile_t& b, const tile_t& c) {
@@ -118,16 +124,15 @@ bool inside_poly(const tiles_t& tiles, const tile_t& a, const tile_t& b)
 
 int64_t part2(const tiles_t& tiles)
 {
-    int64_t largest = 0;
-    for(int i=0; i<tiles.size(); ++i) {
+    return parallel_reduce(0, (int)tiles.size(), int64_t(0), [&](int i){
+        int64_t largest = 0;
         for(int j=i+1; j<tiles.size(); ++j) {
             if(inside_poly(tiles, tiles[i], tiles[j])){
                 largest = std::max(largest, area(tiles[i], tiles[j]));
             }
         }
-    }
-
-    return largest;
+        return largest;
+    }, max_area);
 }
 
 void main()
@@ -136,8 +141,8 @@ void main()
     auto actual_values = load_input("../src/day09/input.txt");
 
     std::cout << "part1: " << part1(test_values) << std::endl;
-    std::cout << "part1: " << part1(actual_values) << std::endl;
+    std::cout << "part1: " << bench("day09", "part1", [&]{ return part1(actual_values); }) << std::endl;
 
     std::cout << "part2: " << part2(test_values) << std::endl;
-    std::cout << "part2: " << part2(actual_values) << std::endl;
+    std::cout << "part2: " << bench("day09", "part2", [&]{ return part2(actual_values); }) << std::endl;
 }
@@ -3,25 +3,30 @@
 #include <string>
 #include <vector>
 #include <regex>
-#include <unordered_set>
 #include <numeric>
-#include <queue>
+#include <algorithm>
+#include <memory_resource>
 #include <functional>
 #include <matrix.hpp>
-#include <omp.h>
+#include <flat_hash.hpp>
+#include <arena.hpp>
+#include <small_vector.hpp>
+#include <bench.hpp>
+#include <thread_pool.hpp>
 
 using light_t = std::string;
 using joltage_t = std::vector<int>;
 
 struct machine_t {
     light_t light;
-    std::vector<std::vector<int>> buttons;
+    std::vector<small_vector<int, 10>> buttons; // lights a button toggles, never more than the light count
     joltage_t joltages;
 };
 
 using machines_t = std::vector<machine_t>;
 
-void parse_ints(const std::string& s, std::vector<int>& out) {
+template<typename Ints>
+void parse_ints(const std::string& s, Ints& out) {
     static const std::regex num_re(R"(\d+)");
     for(auto it = std::sregex_iterator(s.begin(), s.end(), num_re); it != std::sregex_iterator(); ++it) {
         out.push_back(std::stoi((*it).str()));
@@ -54,9 +59,11 @@ machines_t load_input(const std::string& file){
     return ret;
 }
 
+using presses_t = small_vector<int, 16>; // one count per button
+
 struct state_t {
     light_t light;
-    std::vector<int> presses;
+    presses_t presses;
     int total_presses = 0;
 };
 bool operator==(const state_t& a, const state_t& b) { return a.light == b.light && a.presses == b.presses && a.total_presses == b.total_presses; }
@@ -72,18 +79,23 @@ struct hash_t{
     }
 };
 
-auto bfs(const machine_t& machine)
+// the queue and visited table live on the machine's arena and a state's presses sit inline in it, so once the
+// arena has grown the search stops allocating
+auto bfs(const machine_t& machine, arena_resource& arena)
 {
+    arena.reset();
+
     light_t dst = machine.light;
 
-    std::priority_queue<state_t> q;
-    std::unordered_set<state_t, hash_t> visited;
-    q.push({ light_t(dst.size(), '.'), std::vector<int>(machine.buttons.size(), 0) });
+    std::pmr::vector<state_t> q(&arena); // heap ordered by operator<, fewest presses on top
+    flat_hash_set<state_t, hash_t, std::equal_to<state_t>, std::pmr::polymorphic_allocator<state_t>> visited(&arena);
+    q.push_back({ light_t(dst.size(), '.'), presses_t(machine.buttons.size(), 0) });
 
     while (!q.empty()) 
     {
-        auto curr = q.top();
-        q.pop();
+        std::pop_heap(q.begin(), q.end());
+        state_t curr = std::move(q.back());
+        q.pop_back();
 
         if(curr.light == dst){
             return curr.total_presses;
@@ -93,8 +105,6 @@ auto bfs(const machine_t& machine)
             continue;
         }
 
-        visited.insert(curr);
-
         for(int b=0; b<machine.buttons.size(); ++b){
             state_t new_state = curr;
             for(int i : machine.buttons[b]){
@@ -102,8 +112,11 @@ auto bfs(const machine_t& machine)
             }
             new_state.presses[b]++;
             new_state.total_presses++;
-            q.push(new_state);
+            q.push_back(std::move(new_state));
+            std::push_heap(q.begin(), q.end());
         }
+
+        visited.insert(std::move(curr));
     }
 
     return -1;
@@ -111,11 +124,12 @@ auto bfs(const machine_t& machine)
 
 size_t part1(const machines_t& machines)
 {
-    size_t sum = 0;
-    for(auto& machine : machines){
-        sum += bfs(machine);
-    }
-    return sum;
+    auto& pool = thread_pool::global();
+    std::vector<arena_resource> arenas(pool.size()); // one per thread, reset per machine
+
+    return pool.parallel_reduce(0, (int)machines.size(), size_t(0), [&](int i){
+        return (size_t)bfs(machines[i], arenas[pool.slot()]);
+    }, std::plus<size_t>());
 }
 
 template<typename Z>
@@ -165,8 +179,12 @@ std::vector<Z> compute_button_upper_bounds(const matrix<rational<Z>>& A, const s
     return xmax;
 }
 
+// per variable values, inline up to 16 buttons
 template<typename Z>
-bool build_full_x_from_free(const matrix<rational<Z>>& Ab, const linear_solution<Z>& sol, const std::vector<Z>& x_free, std::vector<rational<Z>>& x_out)
+using values_t = small_vector<Z, 16>;
+
+template<typename Z>
+bool build_full_x_from_free(const matrix<rational<Z>>& Ab, const linear_solution<Z>& sol, const values_t<Z>& x_free, values_t<rational<Z>>& x_out)
 {
     size_t n = sol.n_vars;
     size_t rows = Ab.rows;
@@ -202,17 +220,17 @@ bool build_full_x_from_free(const matrix<rational<Z>>& Ab, const linear_solution
 }
 
 template<typename Z>
-void dfs(const matrix<rational<Z>>& Ab, const linear_solution<Z>& sol, const std::vector<Z>& xmax, size_t idx, std::vector<Z>& x_free,  min_press_result<Z>& result)
+void dfs(const matrix<rational<Z>>& Ab, const linear_solution<Z>& sol, const std::vector<Z>& xmax, size_t idx, values_t<Z>& x_free, min_press_result<Z>& result)
 {
     size_t k = sol.free_cols.size();
     size_t n = sol.n_vars;
 
     if(idx == k) {
-        std::vector<rational<Z>> x_rat;
+        values_t<rational<Z>> x_rat;
         build_full_x_from_free(Ab, sol, x_free, x_rat);
 
         Z cost = 0;
-        std::vector<Z> x_int(n);
+        values_t<Z> x_int(n);
 
         for(int j=0; j<n; ++j) {
             const auto& v = x_rat[j];
@@ -231,7 +249,7 @@ void dfs(const matrix<rational<Z>>& Ab, const linear_solution<Z>& sol, const std
 
         result.found = true;
         result.best_cost = cost;
-        result.best_solution = x_int;
+        result.best_solution.assign(x_int.begin(), x_int.end());
         return;
     }
 
@@ -257,7 +275,7 @@ min_press_result<Z> solve(const matrix<rational<Z>>& Ab, const linear_solution<Z
     size_t k = sol.free_cols.size();
 
     if(k == 0) {
-        std::vector<rational<Z>> x_rat(n, rational<Z>(0));
+        values_t<rational<Z>> x_rat(n, rational<Z>(0));
 
         for(int r=0; r<Ab.rows; ++r) {
             int pc = sol.pivot_col_by_row[r];
@@ -267,7 +285,7 @@ min_press_result<Z> solve(const matrix<rational<Z>>& Ab, const linear_solution<Z
         }
 
         Z cost = 0;
-        std::vector<Z> x_int(n);
+        values_t<Z> x_int(n);
 
         for(int j=0; j<n; ++j) {
             auto& v = x_rat[j];
@@ -280,21 +298,18 @@ min_press_result<Z> solve(const matrix<rational<Z>>& Ab, const linear_solution<Z
 
         result.found = true;
         result.best_cost = cost;
-        result.best_solution = x_int;
+        result.best_solution.assign(x_int.begin(), x_int.end());
         return result;
     }
 
-    std::vector<Z> x_free(k, 0);
+    values_t<Z> x_free(k, 0);
     dfs(Ab, sol, xmax, 0, x_free, result);
     return result;
 }
 
 int64_t part2(const machines_t& machines)
 {
-    std::vector<int64_t> sums(machines.size(), 0);
-
-    #pragma omp parallel for
-    for(int i=0; i<machines.size(); ++i) {
+    return parallel_reduce(0, (int)machines.size(), int64_t(0), [&](int i){
         const auto& machine = machines[i];
 
         size_t num_buttons = machine.buttons.size();
@@ -320,10 +335,8 @@ int64_t part2(const machines_t& machines)
         auto xmax = compute_button_upper_bounds(A, b);
         auto res = solve(Ab, sol, xmax);
 
-        sums[i] = res.best_cost;
-    }
-
-    return std::accumulate(sums.begin(), sums.end(), 0LL);
+        return res.best_cost;
+    }, std::plus<int64_t>());
 }
 
 void main() 
@@ -332,8 +345,8 @@ void main()
     auto actual_values = load_input("../src/day10/input.txt");
 
     std::cout << "part1: " << part1(test_values) << std::endl;
-    std::cout << "part1: " << part1(actual_values) << std::endl;
+    std::cout << "part1: " << bench("day10", "part1", [&]{ return part1(actual_values); }) << std::endl;
 
     std::cout << "part2: " << part2(test_values) << std::endl;
-    std::cout << "part2: " << part2(actual_values) << std::endl;
+    std::cout << "part2: " << bench("day10", "part2", [&]{ return part2(actual_values); }) << std::endl;
 }
\ No newline at end of file
@@ -4,83 +4,251 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <atomic>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <cstdlib>
+#include <timer.hpp>
+#include <bench.hpp>
+#include <thread_pool.hpp>
 
-using outputs_t = std::vector<std::string>;
-using connections_t = std::unordered_map<std::string, std::vector<std::string>>;
+struct graph_t {
+    std::unordered_map<std::string, int> ids;
+    std::vector<int> succ_offsets, succs; // csr of outputs
+    std::vector<int> pred_offsets, preds; // csr of inputs
+
+    int size() const { return (int)succ_offsets.size() - 1; }
+    int find(const std::string& name) const { auto it = ids.find(name); return it == ids.end() ? -1 : it->second; }
+};
+
+using edges_t = std::vector<std::pair<int, int>>;
+
+void build_csr(int n, const edges_t& edges, std::vector<int>& offsets, std::vector<int>& targets, bool reverse){
+    offsets.assign(n+1, 0);
+    for(auto& [from, to] : edges){
+        offsets[(reverse ? to : from) + 1]++;
+    }
+    for(int i=0; i<n; ++i){
+        offsets[i+1] += offsets[i];
+    }
+
+    std::vector<int> fill(offsets.begin(), offsets.end()-1);
+    targets.resize(edges.size());
+    for(auto& [from, to] : edges){
+        int src = reverse ? to : from;
+        targets[fill[src]++] = reverse ? from : to;
+    }
+}
+
+void build_graph(graph_t& graph, int n, const edges_t& edges){
+    build_csr(n, edges, graph.succ_offsets, graph.succs, false);
+    build_csr(n, edges, graph.pred_offsets, graph.preds, true);
+}
+
+graph_t load_input(const std::string& file){
+    graph_t ret;
+    edges_t edges;
+    auto id = [&](const std::string& name){
+        return ret.ids.emplace(name, (int)ret.ids.size()).first->second;
+    };
 
-connections_t load_input(const std::string& file){
-    connections_t ret;
     std::ifstream fs(file);
     std::string line;
     while(std::getline(fs, line)) {
         std::istringstream iss(line);
         std::string key, value;
         std::getline(iss, key, ':');
+        int from = id(key);
         while(iss >> value) {
-            ret[key].push_back(value);
+            edges.push_back({ from, id(value) });
         }
     }
+
+    build_graph(ret, (int)ret.ids.size(), edges);
     return ret;
 }
 
-struct path_state_t {
-    std::string node;
-    bool seen_fft = false;
-    bool seen_dac = false;
-};
-bool operator==(const path_state_t& a, const path_state_t& b) { return a.node == b.node && a.seen_fft == b.seen_fft && a.seen_dac == b.seen_dac; }
+using levels_t = std::vector<std::vector<int>>;
+
+// kahn's over the reversed dag, level 0 holds the sinks and every node sits one level above its highest output
+levels_t build_levels(const graph_t& graph, thread_pool& pool = thread_pool::global())
+{
+    int n = graph.size();
+    std::vector<std::atomic<int>> remaining(n);
+    std::vector<int> frontier;
+
+    for(int v=0; v<n; ++v){
+        remaining[v] = graph.succ_offsets[v+1] - graph.succ_offsets[v];
+        if(remaining[v] == 0){
+            frontier.push_back(v);
+        }
+    }
 
-struct path_state_hash_t {
-    size_t operator()(const path_state_t& k) const {
-        return std::hash<std::string>{}(k.node) ^ (((unsigned)k.seen_fft | ((unsigned)k.seen_dac << 1)) * 0x9e3779b97f4a7c15ULL);
+    levels_t levels;
+    std::vector<std::vector<int>> next_frontiers(pool.size());
+
+    while(!frontier.empty())
+    {
+        pool.parallel_for(0, (int)frontier.size(), [&](int i){
+            auto& next = next_frontiers[pool.slot()];
+            int v = frontier[i];
+            for(int e=graph.pred_offsets[v]; e<graph.pred_offsets[v+1]; ++e){
+                int p = graph.preds[e];
+                if(remaining[p].fetch_sub(1, std::memory_order_relaxed) == 1){
+                    next.push_back(p);
+                }
+            }
+        }, 1024);
+
+        levels.push_back(std::move(frontier));
+        frontier.clear();
+        for(auto& next : next_frontiers){
+            frontier.insert(frontier.end(), next.begin(), next.end());
+            next.clear();
+        }
     }
+
+    return levels;
+}
+
+struct path_counts_t {
+    uint64_t by_seen[4] = {}; // indexed by seen_fft | seen_dac << 1
 };
 
-using memo_cache_t = std::unordered_map<path_state_t, int64_t, path_state_hash_t>;
+// pull based, each node only reads outputs from lower levels so no node is written by more than one thread
+std::vector<path_counts_t> count_paths_to_out(const graph_t& graph, const levels_t& levels, thread_pool& pool = thread_pool::global())
+{
+    int out = graph.find("out");
+    int fft = graph.find("fft");
+    int dac = graph.find("dac");
+
+    std::vector<path_counts_t> counts(graph.size());
 
-int64_t find_paths_to_out(const std::string& device, bool seen_fft, bool seen_dac, const connections_t& connections, bool is_part1, memo_cache_t& memo){
-    if(device == "fft") seen_fft = true;
-    if(device == "dac") seen_dac = true;
+    for(auto& level : levels)
+    {
+        pool.parallel_for(0, (int)level.size(), [&](int i){
+            int v = level[i];
+            if(v == out){
+                counts[v].by_seen[0] = 1;
+                return;
+            }
 
-    if(device == "out"){
-        return ((is_part1 || seen_fft && seen_dac) ? 1 : 0);
+            int seen = (v == fft) | ((v == dac) << 1);
+            path_counts_t sum;
+            for(int e=graph.succ_offsets[v]; e<graph.succ_offsets[v+1]; ++e){
+                auto& succ = counts[graph.succs[e]];
+                for(int s=0; s<4; ++s){
+                    sum.by_seen[s | seen] += succ.by_seen[s];
+                }
+            }
+            counts[v] = sum;
+        }, 1024);
     }
 
-    path_state_t path_state { device, seen_fft, seen_dac };
-    if(memo.count(path_state)){
-        return memo[path_state];
+    return counts;
+}
+
+size_t part1(const graph_t& graph)
+{
+    int you = graph.find("you");
+    if(you < 0){
+        return 0;
     }
 
-    int64_t sum = 0;
-    if(connections.count(device)){
-        for(auto& output : connections.at(device)){
-            sum += find_paths_to_out(output, seen_fft, seen_dac, connections, is_part1, memo);
-        }
+    auto counts = count_paths_to_out(graph, build_levels(graph));
+    auto& c = counts[you].by_seen;
+    return c[0] + c[1] + c[2] + c[3];
+}
+
+size_t part2(const graph_t& graph)
+{
+    int svr = graph.find("svr");
+    if(svr < 0){
+        return 0;
     }
 
-    memo[path_state] = sum;
-    return sum;
+    auto counts = count_paths_to_out(graph, build_levels(graph));
+    return counts[svr].by_seen[3];
 }
 
-size_t part1(const connections_t& connections)
+graph_t make_layered_graph(int layers, int width, int fan_out)
 {
-    return find_paths_to_out("you", false, false, connections, true, memo_cache_t());
+    graph_t ret;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> pick(0, width-1);
+
+    int n = layers * width + 1;
+    int out = n - 1;
+    ret.ids["out"] = out;
+    ret.ids["svr"] = 0;
+
+    edges_t edges;
+    edges.reserve((size_t)layers * width * fan_out);
+    for(int l=0; l<layers; ++l){
+        for(int x=0; x<width; ++x){
+            int from = l * width + x;
+            for(int k=0; k<fan_out; ++k){
+                edges.push_back({ from, l+1 < layers ? (l+1) * width + pick(rng) : out });
+            }
+        }
+    }
+
+    build_graph(ret, n, edges);
+    return ret;
 }
 
-size_t part2(const connections_t& connections)
+// thread scaling of the level-synchronous counters on a synthetic graph, 1M nodes and 10M edges. a second or so
+// and a few hundred MB, so it only runs when AOC_DAY11_SCALING is set
+void benchmark()
 {
-    return find_paths_to_out("svr", false, false, connections, false, memo_cache_t());
+    graph_t graph = make_layered_graph(100, 10000, 10);
+    std::cout << "benchmark: " << graph.size() << " nodes, " << graph.succs.size() << " edges" << std::endl;
+
+    // powers of two up to the pool size, plus the pool size and the hardware thread count themselves
+    int max_threads = thread_pool::default_threads();
+    std::vector<int> thread_counts;
+    for(int threads=1; threads<max_threads; threads*=2){
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+    thread_counts.push_back(std::max((int)std::thread::hardware_concurrency(), 1));
+    std::sort(thread_counts.begin(), thread_counts.end());
+    thread_counts.erase(std::unique(thread_counts.begin(), thread_counts.end()), thread_counts.end());
+
+    double base = 0;
+    for(int threads : thread_counts)
+    {
+        thread_pool pool(threads);
+
+        timer t;
+        t.start();
+        auto levels = build_levels(graph, pool);
+        double levels_us = t.microseconds();
+        auto counts = count_paths_to_out(graph, levels, pool);
+        t.stop();
+
+        double total_us = std::max(t.microseconds(), 1.0);
+        if(threads == 1){
+            base = total_us;
+        }
+        std::cout << "threads: " << threads << ", levels: " << levels_us / 1000.0 << "ms, total: " << total_us / 1000.0 << "ms, speedup: " << base / total_us << "x" << std::endl;
+    }
 }
 
-void main() 
+void main()
 {
     auto test_values1 = load_input("../src/day11/test_input.txt");
     auto test_values2 = load_input("../src/day11/test_input2.txt");
     auto actual_values = load_input("../src/day11/input.txt");
 
     std::cout << "part1: " << part1(test_values1) << std::endl;
-    std::cout << "part1: " << part1(actual_values) << std::endl;
+    std::cout << "part1: " << bench("day11", "part1", [&]{ return part1(actual_values); }) << std::endl;
 
     std::cout << "part2: " << part2(test_values2) << std::endl;
-    std::cout << "part2: " << part2(actual_values) << std::endl;
+    std::cout << "part2: " << bench("day11", "part2", [&]{ return part2(actual_values); }) << std::endl;
+
+    if(std::getenv("AOC_DAY11_SCALING")){
+        benchmark();
+    }
 }
\ No newline at end of file
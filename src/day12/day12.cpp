@@ -4,7 +4,20 @@
 #include <string>
 #include <vector>
 #include <unordered_set>
+#include <map>
+#include <deque>
+#include <mutex>
 #include <algorithm>
+#include <numeric>
+#include <cstdlib>
+#include <array>
+#include <bitset>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <bench.hpp>
+#include <thread_pool.hpp>
+#include <arena.hpp>
 
 struct grid_t {
     std::string data;
@@ -69,54 +82,215 @@ situation_t load_input(const std::string& file){
     return ret;
 }
 
-bool place(std::vector<std::vector<grid_t>>& shapes_list, grid_t& grid, int x_steps, int y_steps, int depth, int max_depth){
-    std::vector<int> modified;
-    modified.reserve(9);
-
-    auto& shapes = shapes_list[depth];
-
-    for(int y=0; y<y_steps; ++y){
-        for(int x=0; x<x_steps; ++x){
-
-            for(int z=0; z<shapes.size(); ++z)
-            {
-                for(int idx : modified){ 
-                    grid(idx) = '.'; 
-                } 
-                modified.clear();
-
-                bool valid = true;
-                for(int py=0; py<3 && valid; ++py) {
-                    for(int px=0; px<3; ++px) {
-                        if(shapes[z](px, py) == '#') {
-                            int gx = x + px; int gy = y + py;
-                            int idx = gy * grid.width + gx;
-                            if(grid(idx) == '#'){
-                                valid = false;
-                                break;
-                            }
-                            modified.push_back(idx);
-                            grid(idx) = '#';
-                        }
+using mask_t = std::array<uint64_t, 3>; // one word per row of a 3x3 shape, bit x is column x
+
+int popcount(uint64_t v) {
+    return (int)std::bitset<64>(v).count();
+}
+
+int lowest_bit(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, v);
+    return (int)idx;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+struct orientation_t {
+    mask_t mask;
+    int anchor_x, anchor_y; // first filled cell in row-major order
+};
+
+struct piece_t {
+    int area = 0;
+    std::vector<orientation_t> orientations;
+};
+
+// row y is words[y*stride .. (y+1)*stride), bit x%64 of its word x/64 is cell (x, y), bits past width are walls.
+// a shape 3 wide only straddles two words when it starts in the last 2 bits of one
+struct board_t {
+    std::pmr::vector<uint64_t> words;
+    int width = 0;
+    int height = 0;
+    int stride = 1;
+
+    explicit board_t(std::pmr::memory_resource* resource) : words(resource) {}
+
+    void reset(int w, int h) {
+        stride = (w + 63) / 64;
+        words.assign((size_t)h * stride, 0ull);
+        if(w % 64){
+            for(int y=0; y<h; ++y){
+                words[(size_t)y*stride + stride-1] = ~0ull << (w % 64);
+            }
+        }
+        width = w;
+        height = h;
+    }
+
+    size_t index(int x, int y) const { return (size_t)y*stride + (x >> 6); }
+
+    bool fits(const mask_t& m, int x, int y) const {
+        size_t i = index(x, y);
+        int s = x & 63;
+        uint64_t hit = (words[i] & (m[0] << s)) | (words[i+stride] & (m[1] << s)) | (words[i+2*stride] & (m[2] << s));
+        if(s > 61){
+            hit |= (words[i+1] & (m[0] >> (64-s))) | (words[i+1+stride] & (m[1] >> (64-s))) | (words[i+1+2*stride] & (m[2] >> (64-s)));
+        }
+        return hit == 0;
+    }
+
+    void toggle(const mask_t& m, int x, int y) { apply(words, m, x, y, [](uint64_t& w, uint64_t b){ w ^= b; }); }
+
+    // m at (x, y) or'ed into a buffer laid out like words
+    void cover(std::pmr::vector<uint64_t>& out, const mask_t& m, int x, int y) const { apply(out, m, x, y, [](uint64_t& w, uint64_t b){ w |= b; }); }
+
+    void flip(int x, int y) { words[index(x, y)] ^= 1ull << (x & 63); }
+
+    // first empty cell in row-major order at or after row y, false when the board is full
+    bool first_empty(int& x, int& y) const {
+        for(size_t i=(size_t)y*stride; i<words.size(); ++i){
+            if(words[i] != ~0ull){
+                y = (int)(i / stride);
+                x = (int)(i % stride) * 64 + lowest_bit(~words[i]);
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    template<typename Op>
+    void apply(std::pmr::vector<uint64_t>& out, const mask_t& m, int x, int y, Op op) const {
+        size_t i = index(x, y);
+        int s = x & 63;
+        for(int r=0; r<3; ++r){
+            op(out[i + r*stride], m[r] << s);
+            if(s > 61){
+                op(out[i+1 + r*stride], m[r] >> (64-s));
+            }
+        }
+    }
+};
+
+struct solver_options_t {
+    size_t node_budget = 100000000; // per exact search, regions that run out are left undecided
+    // a search that runs out is retried with dead cell pruning. it costs several times more per node, which
+    // doesn't pay on the regions that are quick anyway, but needs far fewer nodes on the tight ones
+    bool prune_dead_cells = true;
+};
+
+// one per thread. the buffers come from a pool of 64 row boards, so when a taller region grows one the old
+// buffer is handed to the next that grows instead of going back to the heap
+struct search_t {
+    const std::vector<piece_t>& pieces;
+    typed_pool<uint64_t> scratch { 64 };
+    std::pmr::vector<int> remaining { &scratch }; // copies left per shape, identical copies are never told apart
+    board_t board { &scratch };
+    std::pmr::vector<uint64_t> coverage { &scratch }; // scratch for count_dead_cells
+    int slack = 0; // free cells that can still be left empty
+    bool prune_dead_cells = false;
+    size_t node_budget = 0;
+    size_t nodes = 0;
+
+    search_t(const std::vector<piece_t>& p) : pieces(p) {}
+
+    void reset(const region_t& region, int width, int height, int pieces_area, bool prune, const solver_options_t& options) {
+        remaining.assign(pieces.size(), 0);
+        std::copy(region.quantity.begin(), region.quantity.end(), remaining.begin());
+        board.reset(width, height);
+        slack = width * height - pieces_area;
+        prune_dead_cells = prune;
+        node_budget = options.node_budget;
+        nodes = 0;
+    }
+};
+
+// free cells at or after row y0 that no remaining piece can cover in any orientation
+int count_dead_cells(search_t& search, int y0)
+{
+    auto& board = search.board;
+    auto& coverage = search.coverage;
+    coverage.assign(board.words.size(), 0);
+
+    for(int i=0; i<search.pieces.size(); ++i){
+        if(search.remaining[i] == 0){
+            continue;
+        }
+        for(auto& o : search.pieces[i].orientations){
+            for(int y=std::max(y0-2, 0); y<board.height-2; ++y){
+                for(int x=0; x<board.width-2; ++x){
+                    if(board.fits(o.mask, x, y)){
+                        board.cover(coverage, o.mask, x, y);
                     }
                 }
+            }
+        }
+    }
 
-                if(!valid){
-                    continue;
-                }
+    int dead = 0;
+    for(size_t i=(size_t)y0*board.stride; i<board.words.size(); ++i){
+        dead += popcount(~board.words[i] & ~coverage[i]);
+    }
+    return dead;
+}
 
-                if(depth+1 == max_depth){
-                    return true;
-                }
+// the first empty cell is either the anchor of some piece or is left empty for good
+bool place(search_t& search, int pieces_left){
+    if(pieces_left == 0){
+        return true;
+    }
 
-                if(place(shapes_list, grid, x_steps, y_steps, depth+1, max_depth)){
-                    return true;
-                }
+    if(++search.nodes > search.node_budget){
+        return false;
+    }
+
+    auto& board = search.board;
+    int cx = 0, cy = 0;
+    if(!board.first_empty(cx, cy)){
+        return false;
+    }
+
+    if(search.prune_dead_cells && count_dead_cells(search, cy) > search.slack){
+        return false;
+    }
+
+    for(int i=0; i<search.pieces.size(); ++i){
+        if(search.remaining[i] == 0){
+            continue;
+        }
+
+        for(auto& o : search.pieces[i].orientations){
+            int x = cx - o.anchor_x;
+            int y = cy - o.anchor_y;
+            if(x < 0 || y < 0 || x > board.width-3 || y > board.height-3 || !board.fits(o.mask, x, y)){
+                continue;
             }
 
+            board.toggle(o.mask, x, y);
+            search.remaining[i]--;
+            bool placed = place(search, pieces_left-1);
+            search.remaining[i]++;
+            board.toggle(o.mask, x, y);
+
+            if(placed){
+                return true;
+            }
         }
     }
-    return false;
+
+    if(search.slack == 0){
+        return false;
+    }
+
+    board.flip(cx, cy);
+    search.slack--;
+    bool placed = place(search, pieces_left);
+    search.slack++;
+    board.flip(cx, cy);
+    return placed;
 };
 
 grid_t transform(grid_t& in, const int map[9]) {
@@ -127,64 +301,259 @@ grid_t transform(grid_t& in, const int map[9]) {
     return out;
 }
 
-size_t part1(situation_t& situation)
+orientation_t to_orientation(grid_t& shape) {
+    orientation_t o = { {}, -1, -1 };
+    for(int y=0; y<3; ++y){
+        for(int x=0; x<3; ++x){
+            if(shape(x, y) == '#'){
+                o.mask[y] |= 1ull << x;
+                if(o.anchor_x < 0){
+                    o.anchor_x = x;
+                    o.anchor_y = y;
+                }
+            }
+        }
+    }
+    return o;
+}
+
+std::vector<piece_t> build_pieces(const std::vector<grid_t>& shapes)
 {
     int rot[9]  = { 6, 3, 0, 7, 4, 1, 8, 5, 2 };
     int flip[9] = { 2, 1, 0, 5, 4, 3, 8, 7, 6 };
 
-    size_t sum = 0;
-    for(auto& region : situation.regions)
-    {
-        std::vector<std::vector<grid_t>> shape_variants;
-        for(int i=0; i<region.quantity.size(); ++i){
-            for(int j=0; j<region.quantity[i]; ++j){
-                grid_t shape = situation.shapes[i];
-                grid_set shape_set;
-                for(int r=0; r<4; ++r){
-                    shape_set.insert(shape);
-                    shape_set.insert(transform(shape, flip));
-                    shape = transform(shape, rot);
-                }
-                shape_variants.push_back(std::vector<grid_t>(shape_set.begin(), shape_set.end()));
+    std::vector<piece_t> pieces;
+    for(grid_t shape : shapes){
+        grid_set shape_set;
+        for(int r=0; r<4; ++r){
+            shape_set.insert(shape);
+            shape_set.insert(transform(shape, flip));
+            shape = transform(shape, rot);
+        }
+
+        piece_t piece;
+        piece.area = (int)std::count(shape.data.begin(), shape.data.end(), '#');
+        for(grid_t variant : shape_set){
+            piece.orientations.push_back(to_orientation(variant));
+        }
+        pieces.push_back(piece);
+    }
+    return pieces;
+}
+
+enum tier_enum { e_area_bound=0, e_block_bound, e_cache_hit, e_exact_search, e_undecided, e_tier_count };
+
+// e_undecided is an exact search that ran out of budget, fits is false but nothing showed the region can't be packed
+struct verdict_t {
+    bool fits;
+    tier_enum tier;
+};
+
+struct triage_stats_t {
+    size_t decided[e_tier_count] = {};
+};
+
+// a multiset that fits in w x h fits in any box at least as large, one that fails fails in anything smaller
+struct feasibility_cache_t {
+    struct boxes_t {
+        std::vector<std::pair<int, int>> fits, fails; // (short side, long side)
+    };
+
+    std::map<std::vector<int>, boxes_t> known;
+    std::mutex mutex; // regions are triaged concurrently
+
+    static std::vector<int> key(const region_t& region) {
+        std::vector<int> k = region.quantity;
+        while(!k.empty() && k.back() == 0){
+            k.pop_back();
+        }
+        return k;
+    }
+
+    static std::pair<int, int> box(const region_t& region) {
+        return { std::min(region.width, region.height), std::max(region.width, region.height) };
+    }
+
+    bool lookup(const region_t& region, bool& fits) const {
+        auto it = known.find(key(region));
+        if(it == known.end()){
+            return false;
+        }
+
+        auto [w, h] = box(region);
+        for(auto& [fw, fh] : it->second.fits){
+            if(w >= fw && h >= fh){
+                fits = true;
+                return true;
+            }
+        }
+        for(auto& [fw, fh] : it->second.fails){
+            if(w <= fw && h <= fh){
+                fits = false;
+                return true;
             }
         }
+        return false;
+    }
 
-        grid_t new_grid { std::string(region.width*region.height, '.'), region.width, region.height };
-        sum += place(shape_variants, new_grid, region.width-2, region.height-2, 0, (int)shape_variants.size());
+    void insert(const region_t& region, bool fits) {
+        auto& boxes = known[key(region)];
+        (fits ? boxes.fits : boxes.fails).push_back(box(region));
     }
+};
 
-    return sum;
+int pieces_area(const region_t& region, const std::vector<piece_t>& pieces)
+{
+    int area = 0;
+    for(int i=0; i<region.quantity.size(); ++i){
+        area += pieces[i].area * region.quantity[i];
+    }
+    return area;
 }
 
-size_t part2(const situation_t& situation)
+// false when the search ran out of budget before it could tell
+bool exact_search(const region_t& region, search_t& search, bool prune, const solver_options_t& options, bool& fits)
 {
-    std::vector<int> shape_areas;
-    for(auto& shape : situation.shapes){
-        int area = (int)std::count(shape.data.begin(), shape.data.end(), '#');
-        shape_areas.push_back(area);
+    int pieces_left = std::accumulate(region.quantity.begin(), region.quantity.end(), 0);
+
+    // every orientation is available so a region wider than a word but not taller is packed transposed, one word per row
+    int width = region.width, height = region.height;
+    if(width > 64 && height <= 64){
+        std::swap(width, height);
     }
 
-    size_t sum = 0;
-    for(auto& region : situation.regions){
-        int region_spaces = region.width * region.height;
+    search.reset(region, width, height, pieces_area(region, search.pieces), prune, options);
+    fits = place(search, pieces_left);
+    return fits || search.nodes <= options.node_budget;
+}
 
-        int spaces_needed = 0;
-        for(int i=0; i<region.quantity.size(); ++i){
-            spaces_needed += shape_areas[i] * region.quantity[i];
-        }
+verdict_t triage(const region_t& region, search_t& search, feasibility_cache_t& cache, const solver_options_t& options)
+{
+    int pieces_left = std::accumulate(region.quantity.begin(), region.quantity.end(), 0);
+    int area = pieces_area(region, search.pieces);
 
-        if(spaces_needed <= region_spaces){
-            sum++;
+    if(area > region.width * region.height){
+        return { false, e_area_bound };
+    }
+
+    if((region.width/3) * (region.height/3) >= pieces_left){
+        return { true, e_block_bound }; // every piece gets its own 3x3 slot
+    }
+
+    bool cached_fits = false;
+    bool hit = false;
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        hit = cache.lookup(region, cached_fits);
+    }
+    if(hit){
+        return { cached_fits, e_cache_hit };
+    }
+
+    bool fits = false;
+    bool decided = exact_search(region, search, false, options, fits);
+    if(!decided && options.prune_dead_cells){
+        decided = exact_search(region, search, true, options, fits);
+    }
+    if(!decided){
+        return { false, e_undecided }; // looked up again in part1 once every exact result is in the cache
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.insert(region, fits);
+    }
+    return { fits, e_exact_search };
+}
+
+size_t part1(situation_t& situation, triage_stats_t& stats, const solver_options_t& options = solver_options_t())
+{
+    auto pieces = build_pieces(situation.shapes);
+
+    std::vector<verdict_t> verdicts(situation.regions.size());
+    feasibility_cache_t cache;
+
+    // region cost ranges from O(1) to a full search so hand them out one at a time, each thread reusing its own scratch
+    auto& pool = thread_pool::global();
+    std::deque<search_t> searches; // pinned, the vectors point into their own pool
+    for(int t=0; t<pool.size(); ++t){
+        searches.emplace_back(pieces);
+    }
+
+    pool.parallel_for(0, (int)situation.regions.size(), [&](int i){
+        verdicts[i] = triage(situation.regions[i], searches[pool.slot()], cache, options);
+    });
+
+    // whether a region ran out of budget or was answered from the cache first depends on timing. the cache
+    // entries differ from run to run but what they imply does not, every region that can be searched exactly
+    // is either in it or follows from it. so over budget regions look it up again now, after all the inserts
+    for(int i=0; i<verdicts.size(); ++i){
+        bool fits = false;
+        if(verdicts[i].tier == e_undecided && cache.lookup(situation.regions[i], fits)){
+            verdicts[i] = { fits, e_cache_hit };
         }
     }
+
+    size_t sum = 0;
+    for(auto& verdict : verdicts){
+        stats.decided[verdict.tier]++;
+        sum += verdict.fits;
+    }
+
     return sum;
 }
 
+void print_triage(const triage_stats_t& stats)
+{
+    size_t hits = stats.decided[e_cache_hit];
+    size_t lookups = hits + stats.decided[e_exact_search] + stats.decided[e_undecided];
+
+    std::cout << "triage: area bound " << stats.decided[e_area_bound]
+              << ", block bound " << stats.decided[e_block_bound]
+              << ", cache hit " << hits
+              << ", exact search " << stats.decided[e_exact_search]
+              << ", undecided " << stats.decided[e_undecided]
+              << ", cache hit rate " << (lookups ? 100.0 * hits / lookups : 0.0) << "%" << std::endl;
+
+    if(stats.decided[e_undecided]){
+        std::cout << "warning: " << stats.decided[e_undecided] << " regions ran out of search budget and are not counted, part1 is only a lower bound" << std::endl;
+    }
+}
+
+// dead cell pruning may only cut branches that can't be completed, so every region both searches decide
+// must get the same answer with it as without. budgeted lower than part1's so the check stays quick
+bool check_pruning(const situation_t& situation)
+{
+    auto pieces = build_pieces(situation.shapes);
+    search_t search(pieces);
+    solver_options_t options;
+    options.node_budget = 1000000;
+
+    for(auto& region : situation.regions){
+        if(pieces_area(region, pieces) > region.width * region.height){
+            continue;
+        }
+        bool plain = false, pruned = false;
+        if(exact_search(region, search, false, options, plain) && exact_search(region, search, true, options, pruned) && plain != pruned){
+            return false;
+        }
+    }
+    return true;
+}
+
 void main() 
 {
     auto test_values = load_input("../src/day12/test_input.txt");
     auto actual_values = load_input("../src/day12/input.txt");
 
-    std::cout << "part1: " << part1(test_values) << std::endl;
-    std::cout << "part1: " << part2(actual_values) << std::endl;
+    triage_stats_t test_stats, actual_stats;
+    std::cout << "part1: " << part1(test_values, test_stats) << std::endl;
+    std::cout << "part1: " << bench("day12", "part1", [&]{ actual_stats = triage_stats_t(); return part1(actual_values, actual_stats); }) << std::endl;
+
+    print_triage(test_stats);
+    print_triage(actual_stats);
+
+    if(std::getenv("AOC_SELF_CHECK")){
+        std::cout << "pruning check: " << (check_pruning(test_values) && check_pruning(actual_values) ? "ok" : "FAILED") << std::endl;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <memory_resource>
+#include <arena.hpp>
+#include <line_stream.hpp>
+
+// checks of the util headers on the cases the days' inputs may never reach.
+// exits non-zero when any check fails
+
+int g_failures = 0;
+
+void check(bool ok, const std::string& what)
+{
+    if(!ok){
+        std::cout << "FAILED: " << what << std::endl;
+        g_failures++;
+    }
+}
+
+// upstream that counts what is still outstanding, so leaks and bypassed requests show up
+class counting_resource : public std::pmr::memory_resource
+{
+public:
+    size_t allocations = 0;
+    size_t live = 0;
+
+protected:
+    void* do_allocate(size_t bytes, size_t align) override {
+        allocations++;
+        live++;
+        return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t align) override {
+        live--;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+void test_pool_resource()
+{
+    counting_resource upstream;
+    {
+        pool_resource pool(24, &upstream);
+        check(pool.slot_bytes() % alignof(std::max_align_t) == 0 && pool.slot_bytes() >= 24, "pool slots are rounded up to max_align_t");
+
+        void* a = pool.allocate(24);
+        void* b = pool.allocate(8);
+        check(a != b, "pool hands out distinct slots");
+        check((uintptr_t)a % alignof(std::max_align_t) == 0 && (uintptr_t)b % alignof(std::max_align_t) == 0, "pool slots are aligned");
+        check(upstream.allocations == 1, "pool carves small requests from one batch");
+
+        pool.deallocate(a, 24);
+        check(pool.allocate(16) == a, "pool reuses the last freed slot first");
+
+        std::vector<void*> many;
+        for(int i=0; i<1000; ++i){
+            many.push_back(pool.allocate(24));
+        }
+        size_t batches = upstream.allocations;
+        check(batches < 10, "pool batches grow");
+        for(void* p : many){
+            pool.deallocate(p, 24);
+        }
+        for(int i=0; i<1000; ++i){
+            many[i] = pool.allocate(24);
+        }
+        check(upstream.allocations == batches, "freed slots are reused without going upstream");
+
+        size_t before = upstream.allocations;
+        void* big = pool.allocate(pool.slot_bytes() + 1);
+        check(upstream.allocations == before + 1, "oversize requests go upstream");
+        pool.deallocate(big, pool.slot_bytes() + 1);
+        check(upstream.live == batches, "oversize requests are returned upstream");
+    }
+    check(upstream.live == 0, "pool returns every batch on destruction");
+}
+
+void test_typed_pool()
+{
+    counting_resource upstream;
+    {
+        typed_pool<uint64_t> pool(64, &upstream);
+        check(pool.slot_bytes() == 64 * sizeof(uint64_t), "typed pool slots hold count Ts");
+
+        std::pmr::vector<uint64_t> a(&pool), b(&pool);
+        a.assign(40, 1);
+        b.assign(64, 2);
+        a.assign(50, 3); // fits the capacity it already has
+        b.clear();
+        b.shrink_to_fit();
+        a.assign(64, 4);
+        check(upstream.allocations == 1, "vectors up to count elements stay in the pool");
+        check(a.size() == 64 && a[0] == 4 && a[63] == 4, "pool backed vector keeps its contents");
+
+        a.assign(65, 5);
+        check(upstream.allocations == 2 && a[64] == 5, "a vector past count elements moves upstream");
+    }
+    check(upstream.live == 0, "typed pool returns everything on destruction");
+}
+
+// every line as std::getline sees it, less a trailing '\r'
+std::vector<std::string> getline_lines(const std::string& text)
+{
+    std::vector<std::string> lines;
+    std::istringstream is(text);
+    std::string line;
+    while(std::getline(is, line)){
+        if(!line.empty() && line.back() == '\r'){
+            line.pop_back();
+        }
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+void test_line_stream()
+{
+    // empty lines, crlf, a line far longer than the chunks and no newline at the end
+    std::string text = "first\n\nsecond line\r\n" + std::string(100, 'x') + "\n3\n\r\n44\n555\n6666\nlast without newline";
+    auto path = (std::filesystem::temp_directory_path() / "aoc_util_test_lines.txt").string();
+    {
+        std::ofstream fs(path, std::ios::binary);
+        fs << text;
+    }
+    auto expected = getline_lines(text);
+
+    // chunks from a single byte up to past the whole file, so every line ends up split at every offset
+    for(size_t chunk_bytes=1; chunk_bytes<=text.size() + 1; ++chunk_bytes){
+        for(size_t ring_size : { 1, 2, 4 }){
+            std::vector<std::string> lines;
+            line_stream stream(path, chunk_bytes, ring_size);
+            stream.for_each_line([&](std::string_view line){ lines.emplace_back(line); });
+            if(lines != expected){
+                check(false, "line_stream with " + std::to_string(chunk_bytes) + " byte chunks and a ring of " + std::to_string(ring_size) + " matches getline");
+            }
+        }
+    }
+
+    {
+        line_stream stream(path, 1, 1); // the reader is still waiting on a full ring when this is destroyed
+    }
+
+    {
+        std::ofstream fs(path, std::ios::binary);
+    }
+    size_t empty_lines = 0;
+    line_stream(path, 4, 2).for_each_line([&](std::string_view){ empty_lines++; });
+    check(empty_lines == 0, "an empty file has no lines");
+
+    std::filesystem::remove(path);
+}
+
+int main()
+{
+    test_pool_resource();
+    test_typed_pool();
+    test_line_stream();
+
+    std::cout << (g_failures ? "util_test: FAILED" : "util_test: ok") << std::endl;
+    return g_failures ? 1 : 0;
+}
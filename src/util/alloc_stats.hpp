@@ -0,0 +1,219 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <atomic>
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+// peak resident set size of the process so far, in bytes
+inline size_t peak_rss_bytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))){
+        return (size_t)pmc.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;
+#else
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+#ifdef AOC_TRACK_ALLOCATIONS
+
+// opt-in with -DAOC_TRACK_ALLOCATIONS, each executable is one translation unit so the replacement
+// operator new/delete below are defined exactly once
+inline std::atomic<size_t> g_allocations { 0 };
+inline std::atomic<size_t> g_allocated_bytes { 0 };
+inline std::atomic<size_t> g_live_bytes { 0 };
+inline std::atomic<size_t> g_peak_live_bytes { 0 };
+inline std::atomic<size_t> g_phase_peak_live_bytes { 0 };
+
+constexpr size_t alloc_header = 16; // keeps the block max-aligned and remembers its size
+
+inline void count_alloc(size_t size) noexcept
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    size_t live = g_live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    for(auto* high_water : { &g_peak_live_bytes, &g_phase_peak_live_bytes }){
+        size_t peak = high_water->load(std::memory_order_relaxed);
+        while(live > peak && !high_water->compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    }
+}
+
+inline void* tracked_alloc(size_t size) noexcept
+{
+    void* p = std::malloc(size + alloc_header);
+    if(!p){
+        return nullptr;
+    }
+    *(size_t*)p = size;
+    count_alloc(size);
+    return (char*)p + alloc_header;
+}
+
+inline void tracked_free(void* p) noexcept
+{
+    if(!p){
+        return;
+    }
+    void* block = (void*)((uintptr_t)p - alloc_header);
+    g_live_bytes.fetch_sub(*(size_t*)block, std::memory_order_relaxed);
+    std::free(block);
+}
+
+// over-aligned blocks (std::pmr::new_delete_resource always asks for these) keep the malloc pointer and the
+// size just below the aligned address
+struct aligned_header_t {
+    size_t size;
+    void* raw;
+};
+
+inline aligned_header_t* aligned_header(uintptr_t p) noexcept { return (aligned_header_t*)(p - sizeof(aligned_header_t)); }
+
+inline void* tracked_alloc_aligned(size_t size, size_t align) noexcept
+{
+    align = std::max(align, sizeof(aligned_header_t));
+    void* raw = std::malloc(size + 2 * align);
+    if(!raw){
+        return nullptr;
+    }
+    uintptr_t p = ((uintptr_t)raw + align + align - 1) & ~(uintptr_t)(align - 1);
+    *aligned_header(p) = { size, raw };
+    count_alloc(size);
+    return (void*)p;
+}
+
+inline void tracked_free_aligned(void* p) noexcept
+{
+    if(!p){
+        return;
+    }
+    aligned_header_t header = *aligned_header((uintptr_t)p);
+    g_live_bytes.fetch_sub(header.size, std::memory_order_relaxed);
+    std::free(header.raw);
+}
+
+void* operator new(size_t size) {
+    if(void* p = tracked_alloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+    if(void* p = tracked_alloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return tracked_alloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return tracked_alloc(size); }
+void operator delete(void* p) noexcept { tracked_free(p); }
+void operator delete[](void* p) noexcept { tracked_free(p); }
+void operator delete(void* p, size_t) noexcept { tracked_free(p); }
+void operator delete[](void* p, size_t) noexcept { tracked_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { tracked_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { tracked_free(p); }
+
+void* operator new(size_t size, std::align_val_t align) {
+    if(void* p = tracked_alloc_aligned(size, (size_t)align)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size, std::align_val_t align) {
+    if(void* p = tracked_alloc_aligned(size, (size_t)align)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return tracked_alloc_aligned(size, (size_t)align); }
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return tracked_alloc_aligned(size, (size_t)align); }
+void operator delete(void* p, std::align_val_t) noexcept { tracked_free_aligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { tracked_free_aligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { tracked_free_aligned(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { tracked_free_aligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { tracked_free_aligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { tracked_free_aligned(p); }
+
+struct phase_record_t {
+    char name[48];
+    size_t allocations, bytes, peak_live;
+};
+
+inline phase_record_t g_phases[64];
+inline std::atomic<int> g_phase_count { 0 };
+
+// prints every finished phase at exit, then whatever happened outside them (mostly loading) and the totals
+struct alloc_report_t {
+    ~alloc_report_t() {
+        size_t in_phases = 0, bytes_in_phases = 0;
+        int count = std::min(g_phase_count.load(), 64);
+
+        std::cout << "allocations:" << std::endl;
+        for(int i=0; i<count; ++i){
+            auto& r = g_phases[i];
+            std::cout << "  " << r.name << ": " << r.allocations << " allocs, " << r.bytes << " bytes, peak live " << r.peak_live << " bytes" << std::endl;
+            in_phases += r.allocations;
+            bytes_in_phases += r.bytes;
+        }
+        std::cout << "  outside phases: " << g_allocations - in_phases << " allocs, " << g_allocated_bytes - bytes_in_phases << " bytes" << std::endl;
+        std::cout << "  total: " << g_allocations << " allocs, " << g_allocated_bytes << " bytes, peak live " << g_peak_live_bytes << " bytes, peak rss " << peak_rss_bytes() << " bytes" << std::endl;
+    }
+};
+inline alloc_report_t g_alloc_report;
+
+// counts the allocations made while it is alive, from any thread. phases don't nest
+class scoped_phase
+{
+public:
+    scoped_phase(const std::string& name) {
+        std::strncpy(name_, name.c_str(), sizeof(name_) - 1);
+        allocations_ = g_allocations;
+        bytes_ = g_allocated_bytes;
+        g_phase_peak_live_bytes = g_live_bytes.load();
+    }
+
+    ~scoped_phase() {
+        int i = g_phase_count++;
+        if(i < 64){
+            auto& r = g_phases[i];
+            std::memcpy(r.name, name_, sizeof(name_));
+            r.allocations = g_allocations - allocations_;
+            r.bytes = g_allocated_bytes - bytes_;
+            r.peak_live = g_phase_peak_live_bytes;
+        }
+    }
+
+    size_t allocations() const { return g_allocations - allocations_; }
+    size_t bytes() const { return g_allocated_bytes - bytes_; }
+
+private:
+    char name_[48] = {};
+    size_t allocations_ = 0;
+    size_t bytes_ = 0;
+};
+
+#else
+
+class scoped_phase
+{
+public:
+    scoped_phase(const std::string&) {}
+    size_t allocations() const { return 0; }
+    size_t bytes() const { return 0; }
+};
+
+#endif
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+// bump allocation over a list of blocks. deallocate does nothing and reset() rewinds to the first block while
+// keeping them all, so a solver that resets once per machine or region stops calling malloc as soon as the
+// blocks have grown to its working set. unlike std::pmr::monotonic_buffer_resource nothing goes back upstream
+// until release()
+class arena_resource : public std::pmr::memory_resource
+{
+public:
+    explicit arena_resource(size_t block_bytes = 64 * 1024, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : block_bytes_(block_bytes), upstream_(upstream) {}
+
+    ~arena_resource() override { release(); }
+
+    arena_resource(const arena_resource&) = delete;
+    arena_resource& operator=(const arena_resource&) = delete;
+
+    // everything allocated so far is forgotten, not destroyed
+    void reset() {
+        current_ = -1;
+        ptr_ = end_ = nullptr;
+    }
+
+    void release() {
+        for(auto& block : blocks_){
+            upstream_->deallocate(block.data, block.size, alignof(std::max_align_t));
+        }
+        blocks_.clear();
+        reset();
+    }
+
+    size_t bytes_reserved() const {
+        size_t sum = 0;
+        for(auto& block : blocks_){
+            sum += block.size;
+        }
+        return sum;
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t align) override {
+        while(true)
+        {
+            uintptr_t p = ((uintptr_t)ptr_ + align - 1) & ~(uintptr_t)(align - 1);
+            if(ptr_ && p + bytes <= (uintptr_t)end_){
+                ptr_ = (char*)(p + bytes);
+                return (void*)p;
+            }
+            next_block(bytes + align);
+        }
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+    struct block_t {
+        char* data;
+        size_t size;
+    };
+
+    // the next kept block that is big enough, or a new one. blocks double so their count stays logarithmic
+    void next_block(size_t min_bytes) {
+        int i = current_ + 1;
+        while(i < (int)blocks_.size() && blocks_[i].size < min_bytes){
+            ++i;
+        }
+
+        if(i == (int)blocks_.size()){
+            size_t size = std::max(block_bytes_, min_bytes);
+            blocks_.push_back({ (char*)upstream_->allocate(size, alignof(std::max_align_t)), size });
+            block_bytes_ = std::min(block_bytes_ * 2, (size_t)16 << 20);
+        }
+
+        current_ = i;
+        ptr_ = blocks_[i].data;
+        end_ = blocks_[i].data + blocks_[i].size;
+    }
+
+    size_t block_bytes_;
+    std::pmr::memory_resource* upstream_;
+    std::vector<block_t> blocks_;
+    int current_ = -1;
+    char* ptr_ = nullptr;
+    char* end_ = nullptr;
+};
+
+// free list of equal sized slots carved from upstream in growing batches, anything bigger goes straight upstream.
+// objects that are created and destroyed all through a search keep reusing the same few slots
+class pool_resource : public std::pmr::memory_resource
+{
+public:
+    explicit pool_resource(size_t slot_bytes, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : slot_bytes_(round_up(std::max(slot_bytes, sizeof(node_t)))), upstream_(upstream) {}
+
+    ~pool_resource() override {
+        for(auto& chunk : chunks_){
+            upstream_->deallocate(chunk.data, chunk.size, alignof(std::max_align_t));
+        }
+    }
+
+    pool_resource(const pool_resource&) = delete;
+    pool_resource& operator=(const pool_resource&) = delete;
+
+    size_t slot_bytes() const { return slot_bytes_; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t align) override {
+        if(bytes > slot_bytes_ || align > alignof(std::max_align_t)){
+            return upstream_->allocate(bytes, align);
+        }
+        if(!free_){
+            refill();
+        }
+        node_t* node = free_;
+        free_ = node->next;
+        return node;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t align) override {
+        if(bytes > slot_bytes_ || align > alignof(std::max_align_t)){
+            upstream_->deallocate(p, bytes, align);
+            return;
+        }
+        node_t* node = (node_t*)p;
+        node->next = free_;
+        free_ = node;
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+    struct node_t {
+        node_t* next;
+    };
+
+    struct chunk_t {
+        char* data;
+        size_t size;
+    };
+
+    static size_t round_up(size_t bytes) {
+        size_t align = alignof(std::max_align_t);
+        return (bytes + align - 1) / align * align;
+    }
+
+    void refill() {
+        size_t count = batch_;
+        batch_ = std::min(batch_ * 2, (size_t)4096);
+
+        chunk_t chunk { (char*)upstream_->allocate(count * slot_bytes_, alignof(std::max_align_t)), count * slot_bytes_ };
+        chunks_.push_back(chunk);
+        for(size_t i=count; i-- > 0; ){
+            node_t* node = (node_t*)(chunk.data + i * slot_bytes_);
+            node->next = free_;
+            free_ = node;
+        }
+    }
+
+    size_t slot_bytes_;
+    std::pmr::memory_resource* upstream_;
+    std::vector<chunk_t> chunks_;
+    node_t* free_ = nullptr;
+    size_t batch_ = 16;
+};
+
+// pool of slots holding count Ts each, e.g. the buffer of a std::pmr::vector<T> that always has count elements
+template<typename T>
+class typed_pool : public pool_resource
+{
+public:
+    explicit typed_pool(size_t count = 1, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : pool_resource(sizeof(T) * count, upstream) {}
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <timer.hpp>
+#include <alloc_stats.hpp>
+
+// when AOC_BENCH_OUT names a results file, runs f AOC_BENCH_RUNS times (default 10) and appends one
+// "<day> <part> <microseconds> <allocations> <bytes>" line per run so bench_compare can test two runs
+// against each other. otherwise just runs f once. either way the call is an allocation phase
+template<typename F>
+auto bench(const std::string& day, const std::string& part, F&& f)
+{
+    scoped_phase phase(day + " " + part);
+
+    const char* out = std::getenv("AOC_BENCH_OUT");
+    if(!out){
+        return f();
+    }
+
+    const char* runs_env = std::getenv("AOC_BENCH_RUNS");
+    int runs = runs_env ? std::max(1, std::atoi(runs_env)) : 10;
+
+    std::ofstream fs(out, std::ios::app);
+    decltype(f()) result {};
+    for(int r=0; r<runs; ++r){
+        size_t allocations = phase.allocations();
+        size_t bytes = phase.bytes();
+
+        timer t;
+        t.start();
+        result = f();
+        t.stop();
+
+        fs << day << ' ' << part << ' ' << t.microseconds() << ' ' << phase.allocations() - allocations << ' ' << phase.bytes() - bytes << '\n';
+    }
+    return result;
+}
@@ -0,0 +1,441 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <iterator>
+#include <algorithm>
+#include <initializer_list>
+#include <tuple>
+#include <stdexcept>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FLAT_HASH_SSE2
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// open addressing tables in the swisstable layout: one control byte per slot (empty, deleted, or the low 7 bits
+// of the hash) so a probe compares a whole group of control bytes at once and only touches slots whose 7 bits
+// match. values live inline in one array, no node per entry
+namespace flat_hash_detail {
+
+using ctrl_t = int8_t;
+constexpr ctrl_t e_empty = -128;  // 0b10000000
+constexpr ctrl_t e_deleted = -2;  // 0b11111110, full slots are 0b0xxxxxxx
+
+inline int ctz(uint64_t v)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return (int)index;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+// murmur3 finalizer, std::hash of an integer is the identity on the usual standard libraries and the
+// probe position and control bits need well spread high and low bits
+inline uint64_t mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// match positions in a group, shift converts a bit index to a slot index
+struct bitmask_t {
+    uint64_t bits;
+    int shift;
+
+    explicit operator bool() const { return bits != 0; }
+    int lowest() const { return ctz(bits) >> shift; }
+    void clear_lowest() { bits &= bits - 1; }
+};
+
+#ifdef FLAT_HASH_SSE2
+struct group_t {
+    static constexpr int width = 16;
+    __m128i ctrl;
+
+    explicit group_t(const ctrl_t* p) : ctrl(_mm_loadu_si128((const __m128i*)p)) {}
+
+    bitmask_t match(ctrl_t h2) const { return { (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)), 0 }; }
+    bitmask_t match_empty() const { return match(e_empty); }
+    bitmask_t match_empty_or_deleted() const { return { (uint32_t)_mm_movemask_epi8(ctrl), 0 }; }
+};
+#else
+// 8 control bytes in a word, assumes little endian
+struct group_t {
+    static constexpr int width = 8;
+    static constexpr uint64_t lsbs = 0x0101010101010101ull;
+    static constexpr uint64_t msbs = 0x8080808080808080ull;
+    uint64_t ctrl;
+
+    explicit group_t(const ctrl_t* p) { std::memcpy(&ctrl, p, sizeof(ctrl)); }
+
+    // can flag a byte next to a real match, the caller compares keys anyway
+    bitmask_t match(ctrl_t h2) const {
+        uint64_t x = ctrl ^ (lsbs * (uint8_t)h2);
+        return { (x - lsbs) & ~x & msbs, 3 };
+    }
+    bitmask_t match_empty() const { return { ctrl & ~(ctrl << 1) & msbs, 3 }; }
+    bitmask_t match_empty_or_deleted() const { return { ctrl & msbs, 3 }; }
+};
+#endif
+
+// the slots and control bytes come from Alloc (rebound), so a std::pmr allocator puts the whole table on its
+// resource. containers are only ever swapped or moved between equal allocators
+template<typename Value, typename Key, typename KeyOf, typename Hash, typename Eq, typename Alloc>
+class flat_table
+{
+    using slot_alloc_t = typename std::allocator_traits<Alloc>::template rebind_alloc<Value>;
+    using ctrl_alloc_t = typename std::allocator_traits<Alloc>::template rebind_alloc<ctrl_t>;
+
+public:
+    using key_type = Key;
+    using value_type = Value;
+    using size_type = size_t;
+    using allocator_type = Alloc;
+
+    template<bool Const>
+    class iterator_base
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Value;
+        using difference_type = ptrdiff_t;
+        using pointer = std::conditional_t<Const, const Value*, Value*>;
+        using reference = std::conditional_t<Const, const Value&, Value&>;
+
+        iterator_base() = default;
+        iterator_base(const flat_table* table, size_t index) : table_(table), index_(index) { skip(); }
+        template<bool C = Const, typename = std::enable_if_t<C>>
+        iterator_base(const iterator_base<false>& other) : table_(other.table_), index_(other.index_) {}
+
+        reference operator*() const { return table_->slots_[index_]; }
+        pointer operator->() const { return &table_->slots_[index_]; }
+        iterator_base& operator++() { ++index_; skip(); return *this; }
+        iterator_base operator++(int) { auto ret = *this; ++*this; return ret; }
+        bool operator==(const iterator_base& other) const { return index_ == other.index_; }
+        bool operator!=(const iterator_base& other) const { return index_ != other.index_; }
+
+    private:
+        friend class flat_table;
+        friend class iterator_base<true>;
+
+        void skip() {
+            while(index_ < table_->capacity_ && table_->ctrl_[index_] < 0){
+                ++index_;
+            }
+        }
+
+        const flat_table* table_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    using iterator = iterator_base<false>;
+    using const_iterator = iterator_base<true>;
+
+    flat_table() = default;
+    explicit flat_table(const Alloc& alloc) : alloc_(alloc) {}
+
+    flat_table(const flat_table& other)
+        : hash_(other.hash_), eq_(other.eq_), alloc_(std::allocator_traits<Alloc>::select_on_container_copy_construction(other.alloc_)) {
+        copy_from(other);
+    }
+
+    flat_table(flat_table&& other) noexcept : alloc_(other.alloc_) { swap(other); }
+
+    flat_table& operator=(const flat_table& other) {
+        if(this != &other){
+            clear();
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    flat_table& operator=(flat_table&& other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~flat_table() { release(); }
+
+    void swap(flat_table& other) noexcept {
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(deleted_, other.deleted_);
+        std::swap(hash_, other.hash_);
+        std::swap(eq_, other.eq_);
+    }
+
+    allocator_type get_allocator() const { return alloc_; }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, capacity_); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, capacity_); }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return capacity_; }
+
+    void clear() {
+        for(size_t i=0; i<capacity_; ++i){
+            if(ctrl_[i] >= 0){
+                slots_[i].~Value();
+            }
+        }
+        if(capacity_){
+            std::fill(ctrl_, ctrl_ + capacity_ + group_t::width, e_empty);
+        }
+        size_ = 0;
+        deleted_ = 0;
+    }
+
+    // room for n values without a rehash
+    void reserve(size_t n) {
+        size_t capacity = std::max<size_t>(capacity_, 16);
+        while(n > max_load(capacity)){
+            capacity *= 2;
+        }
+        if(capacity != capacity_){
+            rehash(capacity);
+        }
+    }
+
+    iterator find(const Key& key) { return iterator(this, find_index(key)); }
+    const_iterator find(const Key& key) const { return const_iterator(this, find_index(key)); }
+    size_t count(const Key& key) const { return find_index(key) != capacity_; }
+    bool contains(const Key& key) const { return find_index(key) != capacity_; }
+
+    std::pair<iterator, bool> insert(const Value& value) { return emplace_at(KeyOf()(value), value); }
+    std::pair<iterator, bool> insert(Value&& value) { return emplace_at(KeyOf()(value), std::move(value)); }
+
+    size_t erase(const Key& key) {
+        size_t i = find_index(key);
+        if(i == capacity_){
+            return 0;
+        }
+        erase_index(i);
+        return 1;
+    }
+
+    iterator erase(const_iterator it) {
+        erase_index(it.index_);
+        return iterator(this, it.index_ + 1);
+    }
+
+protected:
+    // key must be what args construct to, the value is only built when the key is missing
+    template<typename... Args>
+    std::pair<iterator, bool> emplace_at(const Key& key, Args&&... args) {
+        uint64_t h = mix(hash_(key));
+        size_t i = find_index(key, h);
+        if(i != capacity_){
+            return { iterator(this, i), false };
+        }
+
+        if(size_ + deleted_ + 1 > max_load(capacity_)){
+            // mostly tombstones, clean them out in place rather than grow
+            rehash(capacity_ && size_ + 1 <= max_load(capacity_) / 2 ? capacity_ : std::max<size_t>(capacity_ * 2, 16));
+        }
+
+        i = first_free(h);
+        new (&slots_[i]) Value(std::forward<Args>(args)...);
+        if(ctrl_[i] == e_deleted){
+            deleted_--;
+        }
+        set_ctrl(i, h2(h));
+        size_++;
+        return { iterator(this, i), true };
+    }
+
+    size_t find_index(const Key& key) const { return find_index(key, mix(hash_(key))); }
+
+    size_t find_index(const Key& key, uint64_t h) const {
+        if(!capacity_){
+            return 0;
+        }
+
+        size_t mask = capacity_ - 1;
+        size_t pos = h1(h) & mask;
+        for(size_t step=group_t::width; ; step+=group_t::width){
+            group_t group(ctrl_ + pos);
+            for(auto m = group.match(h2(h)); m; m.clear_lowest()){
+                size_t i = (pos + m.lowest()) & mask;
+                if(eq_(KeyOf()(slots_[i]), key)){
+                    return i;
+                }
+            }
+            if(group.match_empty()){
+                return capacity_;
+            }
+            pos = (pos + step) & mask; // triangular steps over groups visit every group once
+        }
+    }
+
+private:
+    void copy_from(const flat_table& other) {
+        reserve(other.size_);
+        for(auto& value : other){
+            insert(value);
+        }
+    }
+
+    static uint64_t h1(uint64_t h) { return h >> 7; }
+    static ctrl_t h2(uint64_t h) { return (ctrl_t)(h & 0x7f); }
+    static size_t max_load(size_t capacity) { return capacity - capacity / 8; }
+
+    size_t first_free(uint64_t h) const {
+        size_t mask = capacity_ - 1;
+        size_t pos = h1(h) & mask;
+        for(size_t step=group_t::width; ; step+=group_t::width){
+            auto m = group_t(ctrl_ + pos).match_empty_or_deleted();
+            if(m){
+                return (pos + m.lowest()) & mask;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    // the first group's bytes are mirrored past the end so a group load never wraps
+    void set_ctrl(size_t i, ctrl_t c) {
+        ctrl_[i] = c;
+        if(i < group_t::width){
+            ctrl_[capacity_ + i] = c;
+        }
+    }
+
+    void erase_index(size_t i) {
+        slots_[i].~Value();
+        set_ctrl(i, e_deleted);
+        size_--;
+        deleted_++;
+    }
+
+    void rehash(size_t capacity) {
+        ctrl_t* old_ctrl = ctrl_;
+        Value* old_slots = slots_;
+        size_t old_capacity = capacity_;
+
+        ctrl_ = ctrl_alloc_t(alloc_).allocate(capacity + group_t::width);
+        std::fill(ctrl_, ctrl_ + capacity + group_t::width, e_empty);
+        slots_ = slot_alloc_t(alloc_).allocate(capacity);
+        capacity_ = capacity;
+        deleted_ = 0;
+
+        for(size_t i=0; i<old_capacity; ++i){
+            if(old_ctrl[i] >= 0){
+                uint64_t h = mix(hash_(KeyOf()(old_slots[i])));
+                size_t j = first_free(h);
+                new (&slots_[j]) Value(std::move(old_slots[i]));
+                set_ctrl(j, h2(h));
+                old_slots[i].~Value();
+            }
+        }
+
+        if(old_capacity){
+            ctrl_alloc_t(alloc_).deallocate(old_ctrl, old_capacity + group_t::width);
+            slot_alloc_t(alloc_).deallocate(old_slots, old_capacity);
+        }
+    }
+
+    void release() {
+        if(!capacity_){
+            return;
+        }
+        clear();
+        ctrl_alloc_t(alloc_).deallocate(ctrl_, capacity_ + group_t::width);
+        slot_alloc_t(alloc_).deallocate(slots_, capacity_);
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+    }
+
+    ctrl_t* ctrl_ = nullptr;
+    Value* slots_ = nullptr;
+    size_t capacity_ = 0; // power of two, at least one group
+    size_t size_ = 0;
+    size_t deleted_ = 0;
+    Hash hash_;
+    Eq eq_;
+    Alloc alloc_;
+};
+
+template<typename Key>
+struct identity_key {
+    const Key& operator()(const Key& key) const { return key; }
+};
+
+template<typename Pair>
+struct first_key {
+    const typename Pair::first_type& operator()(const Pair& p) const { return p.first; }
+};
+
+}
+
+// drop in for the unordered_set calls used in this repo. pointers and iterators are invalidated by any insert
+template<typename Key, typename Hash = std::hash<Key>, typename Eq = std::equal_to<Key>, typename Alloc = std::allocator<Key>>
+class flat_hash_set : public flat_hash_detail::flat_table<Key, Key, flat_hash_detail::identity_key<Key>, Hash, Eq, Alloc>
+{
+    using base_t = flat_hash_detail::flat_table<Key, Key, flat_hash_detail::identity_key<Key>, Hash, Eq, Alloc>;
+
+public:
+    using base_t::base_t;
+
+    flat_hash_set() = default;
+    flat_hash_set(std::initializer_list<Key> keys) {
+        for(auto& key : keys){
+            this->insert(key);
+        }
+    }
+
+    template<typename... Args>
+    std::pair<typename base_t::iterator, bool> emplace(Args&&... args) {
+        return this->insert(Key(std::forward<Args>(args)...));
+    }
+};
+
+// drop in for the unordered_map calls used in this repo. values are stored as std::pair<Key, Value>, the key
+// must not be changed through an iterator
+template<typename Key, typename Value, typename Hash = std::hash<Key>, typename Eq = std::equal_to<Key>, typename Alloc = std::allocator<std::pair<Key, Value>>>
+class flat_hash_map : public flat_hash_detail::flat_table<std::pair<Key, Value>, Key, flat_hash_detail::first_key<std::pair<Key, Value>>, Hash, Eq, Alloc>
+{
+    using base_t = flat_hash_detail::flat_table<std::pair<Key, Value>, Key, flat_hash_detail::first_key<std::pair<Key, Value>>, Hash, Eq, Alloc>;
+
+public:
+    using base_t::base_t;
+    using mapped_type = Value;
+
+    template<typename... Args>
+    std::pair<typename base_t::iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        return this->emplace_at(key, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template<typename... Args>
+    std::pair<typename base_t::iterator, bool> emplace(const Key& key, Args&&... args) {
+        return try_emplace(key, std::forward<Args>(args)...);
+    }
+
+    Value& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+    Value& at(const Key& key) {
+        auto it = this->find(key);
+        if(it == this->end()){
+            throw std::out_of_range("flat_hash_map::at");
+        }
+        return it->second;
+    }
+};
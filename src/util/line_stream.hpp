@@ -0,0 +1,143 @@
+#pragma once
+
+#include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+
+// reads a file on a background thread into a bounded ring of fixed size chunks that always end on a line
+// boundary, so parsing overlaps the reads and peak memory is ring_size * chunk_bytes whatever the file size
+class line_stream
+{
+public:
+    line_stream(const std::string& file, size_t chunk_bytes = 1 << 20, size_t ring_size = 4)
+        : fs_(file, std::ios::binary), chunk_bytes_(chunk_bytes), ring_(ring_size) {
+        reader_ = std::thread([this]{ read(); });
+    }
+
+    ~line_stream() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        changed_.notify_all();
+        reader_.join();
+    }
+
+    // f(std::string_view line) for every line in order, without the newline
+    template<typename F>
+    void for_each_line(F&& f) {
+        while(true)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [this]{ return consumed_ < produced_ || done_; });
+            if(consumed_ == produced_){
+                return;
+            }
+            const std::vector<char>& chunk = ring_[consumed_ % ring_.size()];
+            lock.unlock();
+
+            size_t begin = 0;
+            for(size_t i=0; i<chunk.size(); ++i){
+                if(chunk[i] == '\n'){
+                    f(line(chunk, begin, i));
+                    begin = i + 1;
+                }
+            }
+            if(begin < chunk.size()){
+                f(line(chunk, begin, chunk.size()));
+            }
+
+            lock.lock();
+            consumed_++;
+            lock.unlock();
+            changed_.notify_all();
+        }
+    }
+
+private:
+    static std::string_view line(const std::vector<char>& chunk, size_t begin, size_t end) {
+        if(end > begin && chunk[end-1] == '\r'){
+            --end;
+        }
+        return std::string_view(chunk.data() + begin, end - begin);
+    }
+
+    void read() {
+        std::vector<char> carry;
+
+        while(true)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            changed_.wait(lock, [this]{ return produced_ - consumed_ < ring_.size() || stopped_; });
+            if(stopped_){
+                break;
+            }
+            std::vector<char>& chunk = ring_[produced_ % ring_.size()];
+            lock.unlock();
+
+            chunk.swap(carry);
+            carry.clear();
+
+            size_t filled = chunk.size();
+            chunk.resize(std::max(chunk_bytes_, filled * 2));
+            fs_.read(chunk.data() + filled, chunk.size() - filled);
+            chunk.resize(filled + (size_t)fs_.gcount());
+
+            bool eof = fs_.gcount() == 0 || !fs_;
+            if(!eof){
+                // hand the partial last line on to the next chunk
+                size_t last = chunk.size();
+                while(last > 0 && chunk[last-1] != '\n'){
+                    --last;
+                }
+                carry.assign(chunk.begin() + last, chunk.end());
+                chunk.resize(last);
+            }
+
+            lock.lock();
+            if(!chunk.empty()){
+                produced_++;
+            }
+            done_ = eof;
+            lock.unlock();
+            changed_.notify_all();
+
+            if(eof){
+                break;
+            }
+        }
+    }
+
+    std::ifstream fs_;
+    size_t chunk_bytes_;
+    std::vector<std::vector<char>> ring_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    size_t produced_ = 0;
+    size_t consumed_ = 0;
+    bool done_ = false;
+    bool stopped_ = false;
+
+    std::thread reader_;
+};
+
+// files past this size are streamed rather than loaded whole. AOC_STREAM_THRESHOLD overrides it in bytes, so 0 streams
+// every input and the streaming paths can be run on inputs that small
+inline bool prefer_streaming(const std::string& file, uintmax_t threshold = 256ull << 20) {
+    if(const char* env = std::getenv("AOC_STREAM_THRESHOLD")){
+        threshold = std::strtoull(env, nullptr, 10);
+    }
+
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(file, ec);
+    return !ec && size > threshold;
+}
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <vector>
 
 template<typename Z = long long>
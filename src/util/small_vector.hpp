@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <initializer_list>
+#include <type_traits>
+
+// vector that keeps its first N elements inside the object and only goes to the heap past that. for the many
+// short lists (button wirings, press counts, free variables) that are otherwise one allocation and one pointer
+// chase each. iterators are plain pointers and, like std::vector, are invalidated by growth and also by moves
+template<typename T, size_t N>
+class small_vector
+{
+    static_assert(N > 0, "use std::vector when nothing fits inline");
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    small_vector() = default;
+
+    explicit small_vector(size_t n, const T& value = T()) { assign(n, value); }
+
+    small_vector(std::initializer_list<T> values) { assign(values.begin(), values.end()); }
+
+    template<typename It, typename = typename std::iterator_traits<It>::iterator_category>
+    small_vector(It first, It last) { assign(first, last); }
+
+    small_vector(const small_vector& other) { assign(other.begin(), other.end()); }
+
+    small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) { take(other); }
+
+    ~small_vector() {
+        clear();
+        release();
+    }
+
+    small_vector& operator=(const small_vector& other) {
+        if(this != &other){
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if(this != &other){
+            clear();
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+    bool is_inline() const { return data_ == inline_data(); }
+
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    T& front() { return data_[0]; }
+    const T& front() const { return data_[0]; }
+    T& back() { return data_[size_-1]; }
+    const T& back() const { return data_[size_-1]; }
+
+    void reserve(size_t n) {
+        if(n > capacity_){
+            grow(n);
+        }
+    }
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args) {
+        if(size_ == capacity_){
+            T value(std::forward<Args>(args)...); // args may refer into the old buffer
+            grow(capacity_ * 2);
+            return emplace_back(std::move(value));
+        }
+        T* p = new (data_ + size_) T(std::forward<Args>(args)...);
+        size_++;
+        return *p;
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    void pop_back() {
+        data_[--size_].~T();
+    }
+
+    void clear() {
+        std::destroy(data_, data_ + size_);
+        size_ = 0;
+    }
+
+    void resize(size_t n) { resize(n, T()); }
+
+    void resize(size_t n, const T& value) {
+        if(n < size_){
+            std::destroy(data_ + n, data_ + size_);
+            size_ = n;
+            return;
+        }
+        T copy(value); // value may refer into the old buffer
+        reserve(n);
+        std::uninitialized_fill(data_ + size_, data_ + n, copy);
+        size_ = n;
+    }
+
+    void assign(size_t n, const T& value) {
+        T copy(value); // value may be one of the elements cleared here
+        clear();
+        resize(n, copy);
+    }
+
+    template<typename It, typename = typename std::iterator_traits<It>::iterator_category>
+    void assign(It first, It last) {
+        clear();
+        for(; first != last; ++first){
+            emplace_back(*first);
+        }
+    }
+
+    friend bool operator==(const small_vector& a, const small_vector& b) { return std::equal(a.begin(), a.end(), b.begin(), b.end()); }
+    friend bool operator!=(const small_vector& a, const small_vector& b) { return !(a == b); }
+    friend bool operator<(const small_vector& a, const small_vector& b) { return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end()); }
+
+private:
+    T* inline_data() { return reinterpret_cast<T*>(inline_); }
+    const T* inline_data() const { return reinterpret_cast<const T*>(inline_); }
+
+    void grow(size_t n) {
+        n = std::max<size_t>(n, N + 1);
+        T* p = std::allocator<T>().allocate(n);
+        std::uninitialized_move(data_, data_ + size_, p);
+        std::destroy(data_, data_ + size_);
+        release();
+        data_ = p;
+        capacity_ = n;
+    }
+
+    void release() {
+        if(!is_inline()){
+            std::allocator<T>().deallocate(data_, capacity_);
+        }
+        data_ = inline_data();
+        capacity_ = N;
+    }
+
+    // this must be empty with no heap block, steals other's heap block or moves its inline elements
+    void take(small_vector& other) {
+        if(other.is_inline()){
+            std::uninitialized_move(other.data_, other.data_ + other.size_, data_);
+            size_ = other.size_;
+            other.clear();
+            return;
+        }
+        data_ = other.data_;
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+        other.data_ = other.inline_data();
+        other.size_ = 0;
+        other.capacity_ = N;
+    }
+
+    T* data_ = inline_data();
+    size_t size_ = 0;
+    size_t capacity_ = N;
+    alignas(T) unsigned char inline_[N * sizeof(T)];
+};
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+// fixed set of worker threads, each owning a deque of tasks. a thread pushes and pops the newest end of its
+// own deque and steals the oldest end of the others when it runs dry. the thread that calls in is one of the
+// `threads`, it works through tasks while it waits instead of blocking, so nested parallel calls never deadlock
+class thread_pool
+{
+public:
+    using task_t = std::function<void()>;
+
+    // AOC_THREADS overrides the hardware thread count so scaling can be measured without a rebuild
+    static int default_threads() {
+        const char* env = std::getenv("AOC_THREADS");
+        int threads = env ? std::atoi(env) : (int)std::thread::hardware_concurrency();
+        return std::max(threads, 1);
+    }
+
+    static thread_pool& global() {
+        static thread_pool pool;
+        return pool;
+    }
+
+    explicit thread_pool(int threads = default_threads()) : queues_(std::max(threads, 1)) {
+        for(int i=1; i<(int)queues_.size(); ++i){
+            workers_.emplace_back([this, i]{ work(i); });
+        }
+    }
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        wake_.notify_all();
+        for(auto& worker : workers_){
+            worker.join();
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // threads doing work, the calling thread included
+    int size() const { return (int)queues_.size(); }
+
+    // 0 for a thread outside the pool, 1..size()-1 for the workers. indexes per thread scratch, which is only
+    // safe while a single outside thread is calling in
+    int slot() const { return t_pool == this ? t_slot : 0; }
+
+    void submit(task_t task) {
+        auto& queue = queues_[slot()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        pending_.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        wake_.notify_one();
+    }
+
+    // runs one queued task on the calling thread, false when there was none to take
+    bool run_one() {
+        task_t task;
+        if(!pop(slot(), task)){
+            return false;
+        }
+        pending_.fetch_sub(1);
+        task();
+        return true;
+    }
+
+    // f(i) for every i in [begin, end), handed out grain indices at a time to whichever thread asks next
+    template<typename F>
+    void parallel_for(int begin, int end, F&& f, int grain = 1);
+
+    // combines f(i) left to right within each chunk of grain indices, then the chunk results left to right, so
+    // the grouping only depends on grain and never on the thread count or timing
+    template<typename T, typename F, typename C>
+    T parallel_reduce(int begin, int end, T identity, F&& f, C&& combine, int grain = 1);
+
+private:
+    struct queue_t {
+        std::mutex mutex;
+        std::deque<task_t> tasks;
+    };
+
+    bool pop(int self, task_t& task) {
+        int n = (int)queues_.size();
+        for(int k=0; k<n; ++k){
+            auto& queue = queues_[(self + k) % n];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if(queue.tasks.empty()){
+                continue;
+            }
+            if(k == 0){
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }else{
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void work(int index) {
+        t_pool = this;
+        t_slot = index;
+
+        while(true)
+        {
+            if(run_one()){
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this]{ return stopped_ || pending_ > 0; });
+            if(stopped_){
+                return;
+            }
+        }
+    }
+
+    inline static thread_local thread_pool* t_pool = nullptr;
+    inline static thread_local int t_slot = 0;
+
+    std::vector<queue_t> queues_; // one per slot
+    std::vector<std::thread> workers_;
+    std::atomic<int> pending_ { 0 };
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopped_ = false;
+};
+
+// tasks that are waited on together. wait() helps run queued work until every task of the group is done
+class task_group
+{
+public:
+    task_group(thread_pool& pool = thread_pool::global()) : pool_(pool) {}
+    ~task_group() { wait(); }
+
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+    template<typename F>
+    void run(F&& f) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_++;
+        }
+        pool_.submit([this, f = std::forward<F>(f)]() mutable {
+            f();
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(--pending_ == 0){
+                done_.notify_all();
+            }
+        });
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while(pending_ > 0)
+        {
+            lock.unlock();
+            bool ran = pool_.run_one();
+            lock.lock();
+
+            // nothing left to take means the rest is running elsewhere, check back now and then in case it spawns more
+            if(!ran){
+                done_.wait_for(lock, std::chrono::milliseconds(1), [this]{ return pending_ == 0; });
+            }
+        }
+    }
+
+private:
+    thread_pool& pool_;
+    std::mutex mutex_;
+    std::condition_variable done_;
+    int pending_ = 0;
+};
+
+template<typename F>
+void thread_pool::parallel_for(int begin, int end, F&& f, int grain)
+{
+    grain = std::max(grain, 1);
+    int chunks = end > begin ? (end - begin + grain - 1) / grain : 0;
+    if(chunks <= 1 || size() == 1){
+        for(int i=begin; i<end; ++i){
+            f(i);
+        }
+        return;
+    }
+
+    std::atomic<int> next { 0 };
+    auto runner = [&]{
+        for(int c; (c = next.fetch_add(1)) < chunks; ){
+            int hi = std::min(end, begin + (c+1) * grain);
+            for(int i=begin + c*grain; i<hi; ++i){
+                f(i);
+            }
+        }
+    };
+
+    task_group group(*this);
+    for(int k=1; k<std::min(chunks, size()); ++k){
+        group.run(runner);
+    }
+    runner();
+    group.wait();
+}
+
+template<typename T, typename F, typename C>
+T thread_pool::parallel_reduce(int begin, int end, T identity, F&& f, C&& combine, int grain)
+{
+    struct partial_t { T value; }; // keeps vector<bool> from packing neighbouring chunks into one word
+
+    grain = std::max(grain, 1);
+    int chunks = end > begin ? (end - begin + grain - 1) / grain : 0;
+    std::vector<partial_t> partials(chunks, partial_t { identity });
+
+    parallel_for(0, chunks, [&](int c){
+        T acc = identity;
+        int hi = std::min(end, begin + (c+1) * grain);
+        for(int i=begin + c*grain; i<hi; ++i){
+            acc = combine(acc, f(i));
+        }
+        partials[c].value = acc;
+    });
+
+    T ret = identity;
+    for(auto& partial : partials){
+        ret = combine(ret, partial.value);
+    }
+    return ret;
+}
+
+template<typename F>
+void parallel_for(int begin, int end, F&& f, int grain = 1)
+{
+    thread_pool::global().parallel_for(begin, end, std::forward<F>(f), grain);
+}
+
+template<typename T, typename F, typename C>
+T parallel_reduce(int begin, int end, T identity, F&& f, C&& combine, int grain = 1)
+{
+    return thread_pool::global().parallel_reduce(begin, end, identity, std::forward<F>(f), std::forward<C>(combine), grain);
+}